@@ -0,0 +1,298 @@
+#include "acr-session.h"
+#include "platform.h"
+#include "metrics.h"
+
+// the buffers are written by the transport on every APDU and read by the drivers right after, keep each of them on its own cache lines
+#define ACR_SESSION_ALIGNMENT 64
+
+struct acr_session {
+    BYTE pbRecvBuffer[ACR_SESSION_RECV_BUFFER_SIZE] __attribute__((aligned(ACR_SESSION_ALIGNMENT)));
+    BYTE pbRecvBufferLarge[ACR_SESSION_RECV_BUFFER_LARGE_SIZE] __attribute__((aligned(ACR_SESSION_ALIGNMENT)));
+
+    SCARDHANDLE hCard __attribute__((aligned(ACR_SESSION_ALIGNMENT)));
+    const Transport *transport;
+    AcrSessionStats stats;
+    ApduTrace trace;                // the last exchanges of this session only (see apdu_trace_dump)
+
+    // transaction state
+    AcrTransactionGranularity granularity;
+    DWORD operationDepth;           // nesting level of acr_session_begin_operation
+    BOOL inTransaction;
+    int transactionSector;          // sector covered by the current transaction (ACR_TRANSACTION_PER_SECTOR), -1: none yet
+    const char *operationName;      // outermost operation, only timed while metrics are enabled
+    BOOL operationTimed;
+    uint64_t operationStart_us;
+
+    // mifare classic state: which key sits in which reader key slot, which sector the tag is authenticated for
+    BYTE keySlots[ACR_SESSION_KEY_SLOTS][ACR_SESSION_KEY_LENGTH];
+    BOOL keySlotLoaded[ACR_SESSION_KEY_SLOTS];
+    int authenticatedSector;        // -1: none
+    BYTE authenticatedKeyType;
+    BYTE authenticatedKey[ACR_SESSION_KEY_LENGTH];
+
+    // type 2 state: the tag accepted PWD_AUTH with this password
+    BOOL type2Authenticated;
+    BYTE type2Password[ACR_SESSION_PASSWORD_LENGTH];
+
+    // cached tag state (forgotten whenever the tag changes)
+    BYTE uid[ACR_SESSION_MAX_UID];
+    BYTE uidLength;                 // 0: unknown
+    char tagName[100];              // "" : unknown
+};
+
+// acr_session_create allocates a session for hCard (0 if there is no tag yet, see acr_session_set_handle), returns NULL if out of memory
+// the session uses the transport that is active at the time of creation (see setTransport)
+acr_session *acr_session_create(SCARDHANDLE hCard) {
+    acr_session *session = platform_aligned_alloc(ACR_SESSION_ALIGNMENT, sizeof(acr_session));
+    if (session == NULL) {
+        return NULL;
+    }
+    memset(session, 0, sizeof(*session));
+    session->hCard = hCard;
+    session->transport = getTransport();
+    session->granularity = ACR_TRANSACTION_PER_OPERATION;
+    session->transactionSector = -1;
+    session->authenticatedSector = -1;
+
+    return session;
+}
+
+void acr_session_destroy(acr_session *session) {
+    platform_aligned_free(session);
+}
+
+SCARDHANDLE acr_session_handle(const acr_session *session) {
+    return session->hCard;
+}
+
+// acr_session_set_handle switches to another card handle, which means that everything cached about the tag is forgotten
+void acr_session_set_handle(acr_session *session, SCARDHANDLE hCard) {
+    session->hCard = hCard;
+    acr_session_tag_changed(session);
+}
+
+const Transport *acr_session_transport(const acr_session *session) {
+    return session->transport;
+}
+
+// acr_session_set_transport overrides the transport of this session only (pass NULL for pcsc)
+void acr_session_set_transport(acr_session *session, const Transport *transport) {
+    session->transport = (transport != NULL) ? transport : &PCSC_TRANSPORT;
+}
+
+// acr_session_recv_buffer holds the response of the most recent APDU (ACR_SESSION_RECV_BUFFER_SIZE bytes)
+BYTE *acr_session_recv_buffer(acr_session *session) {
+    return session->pbRecvBuffer;
+}
+
+BYTE *acr_session_recv_buffer_large(acr_session *session) {
+    return session->pbRecvBufferLarge;
+}
+
+// acr_session_trace is the APDU trace of this session, executeApdu records into it
+ApduTrace *acr_session_trace(acr_session *session) {
+    return &session->trace;
+}
+
+// acr_session_record_apdu is called by executeApdu for every exchange
+void acr_session_record_apdu(acr_session *session, DWORD sentBytes, DWORD receivedBytes, LONG status) {
+    session->stats.apdus++;
+    session->stats.bytesSent += sentBytes;
+    if (status == SCARD_S_SUCCESS) {
+        session->stats.bytesReceived += receivedBytes;
+    } else {
+        session->stats.apduFailures++;
+    }
+}
+
+const AcrSessionStats *acr_session_stats(const acr_session *session) {
+    return &session->stats;
+}
+
+void acr_session_reset_stats(acr_session *session) {
+    memset(&session->stats, 0, sizeof(session->stats));
+}
+
+// -------------------- Transactions -------------------------------
+
+void acr_session_set_transaction_granularity(acr_session *session, AcrTransactionGranularity granularity) {
+    session->granularity = granularity;
+}
+
+AcrTransactionGranularity acr_session_transaction_granularity(const acr_session *session) {
+    return session->granularity;
+}
+
+// a transaction that fails to start is not an error: the APDUs still work, they just are not exclusive (e.g. the transport has no transactions).
+// other pcsc clients might have used the reader since the last transaction, so its key slots and the authenticated sector are unknown again
+static void acr_session_transaction_start(acr_session *session) {
+    const Transport *transport = session->transport;
+    session->authenticatedSector = -1;
+    acr_session_forget_key_slots(session);
+    if ((transport->beginTransaction != NULL) && (transport->beginTransaction(session->hCard) == SCARD_S_SUCCESS)) {
+        session->inTransaction = TRUE;
+        session->stats.transactions++;
+    }
+}
+
+static void acr_session_transaction_stop(acr_session *session) {
+    if (session->inTransaction) {
+        session->transport->endTransaction(session->hCard);
+        session->inTransaction = FALSE;
+    }
+}
+
+// acr_session_begin_operation marks the start of a composite driver function (name: usually __func__), every call needs a matching acr_session_end_operation
+void acr_session_begin_operation(acr_session *session, const char *name) {
+    if (session->operationDepth++ > 0) {
+        return; // nested operation (e.g. reset_card -> write_block), the outer one already decided
+    }
+    session->operationName = name;
+    session->operationTimed = metrics_enabled();
+    if (session->operationTimed) {
+        session->operationStart_us = platform_monotonic_us();
+    }
+    session->transactionSector = -1;
+    if (session->granularity != ACR_TRANSACTION_NONE) {
+        acr_session_transaction_start(session);
+    }
+}
+
+// acr_session_enter_sector is called by the mifare classic drivers before they touch a sector. With ACR_TRANSACTION_PER_SECTOR the
+// transaction is renewed whenever the sector changes, which gives other pcsc clients a chance to use the reader in between sectors
+void acr_session_enter_sector(acr_session *session, int sector) {
+    if ((session->granularity != ACR_TRANSACTION_PER_SECTOR) || (session->operationDepth == 0) || (sector == session->transactionSector)) {
+        return;
+    }
+    if (session->transactionSector != -1) {
+        acr_session_transaction_stop(session);
+        acr_session_transaction_start(session);
+    }
+    session->transactionSector = sector;
+}
+
+// acr_session_end_operation closes the operation of acr_session_begin_operation and passes success through (see ACR_SESSION_OPERATION)
+BOOL acr_session_end_operation(acr_session *session, BOOL success) {
+    if ((session->operationDepth == 0) || (--session->operationDepth > 0)) {
+        return success;
+    }
+    acr_session_transaction_stop(session);
+    if (session->operationTimed) {
+        metrics_record_operation(session->operationName, platform_monotonic_us() - session->operationStart_us);
+    }
+    return success;
+}
+
+// -------------------- Mifare Classic authentication -------------------------------
+
+// acr_session_key_slot_of returns the reader key slot that holds key, -1 if it is in none of them (a hit counts as a skipped key load).
+// outside of a transaction other pcsc clients may load their own keys in between any two APDUs, nothing is known then
+int acr_session_key_slot_of(acr_session *session, const BYTE *key) {
+    if (!session->inTransaction) {
+        return -1;
+    }
+    for (int slot = 0; slot < ACR_SESSION_KEY_SLOTS; slot++) {
+        if (session->keySlotLoaded[slot] && (memcmp(session->keySlots[slot], key, ACR_SESSION_KEY_LENGTH) == 0)) {
+            session->stats.keyLoadsSkipped++;
+            return slot;
+        }
+    }
+    return -1;
+}
+
+// acr_session_set_key_slot is called after key was loaded into slot successfully
+void acr_session_set_key_slot(acr_session *session, BYTE slot, const BYTE *key) {
+    if (slot >= ACR_SESSION_KEY_SLOTS) {
+        return;
+    }
+    memcpy(session->keySlots[slot], key, ACR_SESSION_KEY_LENGTH);
+    session->keySlotLoaded[slot] = TRUE;
+}
+
+// acr_session_is_authenticated tells whether the tag still is authenticated for sector with the given key type and key (a hit counts as a skipped authentication),
+// never outside of a transaction (see acr_session_key_slot_of)
+BOOL acr_session_is_authenticated(acr_session *session, int sector, BYTE keyType, const BYTE *key) {
+    BOOL authenticated = session->inTransaction &&
+                         (session->authenticatedSector != -1) &&
+                         (session->authenticatedSector == sector) &&
+                         (session->authenticatedKeyType == keyType) &&
+                         (memcmp(session->authenticatedKey, key, ACR_SESSION_KEY_LENGTH) == 0);
+    if (authenticated) {
+        session->stats.authsSkipped++;
+    }
+    return authenticated;
+}
+
+// acr_session_set_authenticated is called after a successful authentication (the tag is authenticated for one sector at a time)
+void acr_session_set_authenticated(acr_session *session, int sector, BYTE keyType, const BYTE *key) {
+    session->authenticatedSector = sector;
+    session->authenticatedKeyType = keyType;
+    memcpy(session->authenticatedKey, key, ACR_SESSION_KEY_LENGTH);
+}
+
+// acr_session_forget_authentication is called by executeApdu for every failed APDU: the tag drops its crypto1 session (or its PWD_AUTH) on any error
+void acr_session_forget_authentication(acr_session *session) {
+    session->authenticatedSector = -1;
+    session->type2Authenticated = FALSE;
+}
+
+// acr_session_forget_key_slots is called when the reader itself might have lost its volatile key slots (transport error, new handle)
+void acr_session_forget_key_slots(acr_session *session) {
+    memset(session->keySlotLoaded, 0, sizeof(session->keySlotLoaded));
+}
+
+// -------------------- Type 2 password -------------------------------
+
+// acr_session_is_type2_authenticated tells whether the tag accepted password since it came onto the reader and did not answer with an error since,
+// password NULL: any password (a hit with a password counts as a skipped authentication)
+BOOL acr_session_is_type2_authenticated(acr_session *session, const BYTE *password) {
+    if (!session->type2Authenticated) {
+        return FALSE;
+    }
+    if (password == NULL) {
+        return TRUE;
+    }
+    BOOL authenticated = (memcmp(session->type2Password, password, ACR_SESSION_PASSWORD_LENGTH) == 0);
+    if (authenticated) {
+        session->stats.authsSkipped++;
+    }
+    return authenticated;
+}
+
+// acr_session_set_type2_authenticated is called after the tag accepted PWD_AUTH with password
+void acr_session_set_type2_authenticated(acr_session *session, const BYTE *password) {
+    memcpy(session->type2Password, password, ACR_SESSION_PASSWORD_LENGTH);
+    session->type2Authenticated = TRUE;
+}
+
+// acr_session_tag_changed must be called whenever another tag is (or might be) on the reader
+void acr_session_tag_changed(acr_session *session) {
+    acr_session_forget_authentication(session);
+    acr_session_forget_key_slots(session);
+    session->uidLength = 0;
+    session->tagName[0] = '\0';
+    session->stats.tags++;
+}
+
+void acr_session_set_uid(acr_session *session, const BYTE *uid, BYTE uidLength) {
+    if (uidLength > ACR_SESSION_MAX_UID) {
+        uidLength = 0;
+    }
+    memcpy(session->uid, uid, uidLength);
+    session->uidLength = uidLength;
+}
+
+// acr_session_uid copies the cached UID (up to ACR_SESSION_MAX_UID bytes) to uid and returns its length (0 if it was not read yet)
+BYTE acr_session_uid(const acr_session *session, BYTE *uid) {
+    memcpy(uid, session->uid, session->uidLength);
+    return session->uidLength;
+}
+
+void acr_session_set_tag_name(acr_session *session, const char *tagName) {
+    strncpy(session->tagName, tagName, sizeof(session->tagName) - 1);
+    session->tagName[sizeof(session->tagName) - 1] = '\0';
+}
+
+const char *acr_session_tag_name(const acr_session *session) {
+    return session->tagName;
+}
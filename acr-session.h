@@ -0,0 +1,103 @@
+#ifndef ACR_SESSION_H
+#define ACR_SESSION_H
+
+#ifndef COMMON_H
+#include "common.h"
+#endif
+
+#ifndef TRANSPORT_H
+#include "transport.h"
+#endif
+
+#ifndef APDU_TRACE_H
+#include "apdu-trace.h"
+#endif
+
+// An acr_session is everything the drivers need to talk to one tag on one reader: the card handle, the transport, the receive buffers,
+// statistics and what is known about the reader / tag so far. It replaces the (hCard, pbRecvBuffer, pbRecvBufferSize) triple that
+// used to be passed to every driver function. Each session owns its own memory, so several sessions (e.g. one per reader thread,
+// see reader-pool.c) can run in parallel without sharing any mutable state.
+// The struct is opaque, create it with acr_session_create and free it with acr_session_destroy.
+
+#define ACR_SESSION_RECV_BUFFER_SIZE 256          // PN532 can only transfer 256 bytes at once (page 29 of PN532 application note)
+#define ACR_SESSION_RECV_BUFFER_LARGE_SIZE 2048   // SCardStatus and friends
+#define ACR_SESSION_MAX_UID 10
+#define ACR_SESSION_KEY_SLOTS 2                    // volatile key slots 0x00 and 0x01 of the ACR122U (FF 82)
+#define ACR_SESSION_KEY_LENGTH 6
+#define ACR_SESSION_PASSWORD_LENGTH 4              // type 2 PWD_AUTH
+
+typedef struct acr_session acr_session;
+
+// AcrTransactionGranularity decides how composite driver operations (reset, format, multi-sector reads) are wrapped in
+// SCardBeginTransaction / SCardEndTransaction. Without a transaction pcscd takes and releases its reader lock around every
+// single APDU and other clients can interleave their own APDUs (e.g. in between an authentication and the following write).
+typedef enum AcrTransactionGranularity {
+    ACR_TRANSACTION_NONE,           // every APDU on its own (key slots and authentications can not be reused, see acr_session_key_slot_of)
+    ACR_TRANSACTION_PER_SECTOR,     // one transaction per mifare classic sector (type 2 tags have no sectors: one per operation)
+    ACR_TRANSACTION_PER_OPERATION,  // one transaction per driver function (default)
+} AcrTransactionGranularity;
+
+typedef struct AcrSessionStats {
+    uint64_t apdus;             // every call of executeApdu
+    uint64_t apduFailures;      // transport returned an error
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    uint64_t tags;              // how often acr_session_tag_changed was called
+    uint64_t transactions;      // successful SCardBeginTransaction calls
+    uint64_t keyLoadsSkipped;   // load key APDUs that were not sent because the key already was in a slot
+    uint64_t authsSkipped;      // authenticate APDUs that were not sent because the sector already was authenticated
+} AcrSessionStats;
+
+acr_session *acr_session_create(SCARDHANDLE hCard);
+void acr_session_destroy(acr_session *session);
+
+SCARDHANDLE acr_session_handle(const acr_session *session);
+void acr_session_set_handle(acr_session *session, SCARDHANDLE hCard);
+const Transport *acr_session_transport(const acr_session *session);
+void acr_session_set_transport(acr_session *session, const Transport *transport);
+
+BYTE *acr_session_recv_buffer(acr_session *session);
+BYTE *acr_session_recv_buffer_large(acr_session *session);
+ApduTrace *acr_session_trace(acr_session *session);
+
+void acr_session_record_apdu(acr_session *session, DWORD sentBytes, DWORD receivedBytes, LONG status);
+const AcrSessionStats *acr_session_stats(const acr_session *session);
+void acr_session_reset_stats(acr_session *session);
+
+// operations: transactions + timing (see metrics.h), called by the drivers (operations may nest, only the outermost one counts).
+// callers batch several driver calls by holding an operation around them: the calls then share one transaction and the mifare classic
+// key slot / authentication cache below, e.g. 3 mifare_classic_write_block calls in one sector cost one authentication instead of three
+void acr_session_set_transaction_granularity(acr_session *session, AcrTransactionGranularity granularity);
+AcrTransactionGranularity acr_session_transaction_granularity(const acr_session *session);
+void acr_session_begin_operation(acr_session *session, const char *name);
+void acr_session_enter_sector(acr_session *session, int sector);
+BOOL acr_session_end_operation(acr_session *session, BOOL success);
+
+// ACR_SESSION_OPERATION evaluates the BOOL expression 'call' as one operation named after the enclosing function, e.g.
+//      return ACR_SESSION_OPERATION(session, do_mifare_classic_read_sector(sector, keyType, key, session));
+#define ACR_SESSION_OPERATION(session, call) (acr_session_begin_operation((session), __func__), acr_session_end_operation((session), (call)))
+
+// mifare classic key slots / authentication state (see mifare_classic_authenticate), forgotten on tag changes, failed APDUs and at the start of every
+// outermost operation, and never used outside of a transaction: the key slots belong to the reader, and any other pcsc client can load its own keys
+// into them or authenticate another sector in between two of our transactions. a stale slot would make FF 86 fail and a correct key look wrong
+int acr_session_key_slot_of(acr_session *session, const BYTE *key);
+void acr_session_set_key_slot(acr_session *session, BYTE slot, const BYTE *key);
+BOOL acr_session_is_authenticated(acr_session *session, int sector, BYTE keyType, const BYTE *key);
+void acr_session_set_authenticated(acr_session *session, int sector, BYTE keyType, const BYTE *key);
+void acr_session_forget_authentication(acr_session *session);
+void acr_session_forget_key_slots(acr_session *session);
+
+// type 2 PWD_AUTH state (see type2_authenticate), forgotten together with the mifare classic authentication, but kept across operations:
+// it lives in the tag, not in the reader, and only ends when the tag leaves the field or answers with a NAK. if another pcsc client
+// caused that NAK, our next protected command gets a NAK of its own (which forgets the state) instead of a silently wrong result
+BOOL acr_session_is_type2_authenticated(acr_session *session, const BYTE *password);
+void acr_session_set_type2_authenticated(acr_session *session, const BYTE *password);
+
+// cached reader / tag state
+void acr_session_tag_changed(acr_session *session);
+void acr_session_set_uid(acr_session *session, const BYTE *uid, BYTE uidLength);
+BYTE acr_session_uid(const acr_session *session, BYTE *uid);
+void acr_session_set_tag_name(acr_session *session, const char *tagName);
+const char *acr_session_tag_name(const acr_session *session);
+
+#endif
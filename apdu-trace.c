@@ -0,0 +1,58 @@
+#include "apdu-trace.h"
+
+static BOOL apduTraceEnabled = TRUE;
+
+// apdu_trace_enable turns recording on or off (it is on by default, recording is cheap)
+void apdu_trace_enable(BOOL enabled) {
+    apduTraceEnabled = enabled;
+}
+
+// apdu_trace_record is called by executeApdu for every exchange with the reader (trace belongs to the session that sent it)
+void apdu_trace_record(ApduTrace *trace, const BYTE *pbSendBuffer, DWORD dwSendLength, const BYTE *pbRecvBuffer, DWORD dwRecvLength, LONG status) {
+    if (!apduTraceEnabled) {
+        return;
+    }
+
+    uint32_t sequence = trace->count++;
+    ApduTraceEntry *entry = &trace->entries[sequence % APDU_TRACE_ENTRIES];
+    entry->sequence = sequence;
+    entry->status = status;
+    entry->sendLength = (uint16_t)dwSendLength;
+    entry->recvLength = (status == SCARD_S_SUCCESS) ? (uint16_t)dwRecvLength : 0;
+    memcpy(entry->send, pbSendBuffer, (dwSendLength < APDU_TRACE_MAX_BYTES) ? dwSendLength : APDU_TRACE_MAX_BYTES);
+    memcpy(entry->recv, pbRecvBuffer, (entry->recvLength < APDU_TRACE_MAX_BYTES) ? entry->recvLength : APDU_TRACE_MAX_BYTES);
+}
+
+static void apdu_trace_print_bytes(const char *prefix, const BYTE *data, uint16_t length) {
+    printf("%s", prefix);
+    for (uint16_t i = 0; i < length && i < APDU_TRACE_MAX_BYTES; i++) {
+        printf("%02x ", data[i]);
+    }
+    if (length > APDU_TRACE_MAX_BYTES) {
+        printf(".. (%u bytes)", length);
+    }
+    printf("\n");
+}
+
+// apdu_trace_dump prints the recorded APDUs from oldest to newest
+void apdu_trace_dump(const ApduTrace *trace) {
+    uint32_t first = (trace->count > APDU_TRACE_ENTRIES) ? trace->count - APDU_TRACE_ENTRIES : 0;
+
+    printf("\nLast %u of %u APDUs:\n", trace->count - first, trace->count);
+    for (uint32_t i = first; i < trace->count; i++) {
+        const ApduTraceEntry *entry = &trace->entries[i % APDU_TRACE_ENTRIES];
+
+        printf("#%u\n", entry->sequence);
+        apdu_trace_print_bytes("> ", entry->send, entry->sendLength);
+        if (entry->status == SCARD_S_SUCCESS) {
+            apdu_trace_print_bytes("< ", entry->recv, entry->recvLength);
+        } else {
+            printf("< %08lx\n", (unsigned long)entry->status);
+        }
+    }
+    printf("\n");
+}
+
+void apdu_trace_clear(ApduTrace *trace) {
+    trace->count = 0;
+}
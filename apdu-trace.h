@@ -0,0 +1,34 @@
+#ifndef APDU_TRACE_H
+#define APDU_TRACE_H
+
+#ifndef COMMON_H
+#include "common.h"
+#endif
+
+// The APDU trace is a preallocated ring buffer that remembers the last APDU_TRACE_ENTRIES exchanges (command, response and status).
+// Recording is a couple of memcpys, nothing is printed until apdu_trace_dump() is called (e.g. after something went wrong).
+// Every acr_session has its own trace (see acr_session_trace), so reader threads never write to the same one.
+
+#define APDU_TRACE_ENTRIES 128
+#define APDU_TRACE_MAX_BYTES 24 // longer commands / responses are truncated in the trace
+
+typedef struct ApduTraceEntry {
+    uint32_t sequence;              // counts up with every recorded APDU (so you can tell how many got overwritten)
+    LONG status;                    // return value of the transport
+    uint16_t sendLength;            // untruncated lengths
+    uint16_t recvLength;
+    BYTE send[APDU_TRACE_MAX_BYTES];
+    BYTE recv[APDU_TRACE_MAX_BYTES];
+} ApduTraceEntry;
+
+typedef struct ApduTrace {
+    ApduTraceEntry entries[APDU_TRACE_ENTRIES];
+    uint32_t count;                 // total amount of recorded APDUs (the next entry is written to count % APDU_TRACE_ENTRIES)
+} ApduTrace;
+
+void apdu_trace_enable(BOOL enabled);
+void apdu_trace_record(ApduTrace *trace, const BYTE *pbSendBuffer, DWORD dwSendLength, const BYTE *pbRecvBuffer, DWORD dwRecvLength, LONG status);
+void apdu_trace_dump(const ApduTrace *trace);
+void apdu_trace_clear(ApduTrace *trace);
+
+#endif
@@ -0,0 +1,558 @@
+// bench.c runs the existing driver functions against the in-process tag simulator (simulator.c) and reports
+// how many tags per minute they would manage with the latency model of a real ACR122U. No reader is required, so this also runs on CI.
+//      Compile with: make bench
+//      Run with:     ./bench [iterations] [--realtime] [--readers N]
+//          --realtime actually sleeps for the modelled latency instead of only adding it up (slow, but useful to sanity check wall-clock numbers)
+//          --metrics   records APDU / operation latency histograms (metrics.c) and prints them after the first table
+//                      (host time only, unless combined with --realtime)
+//          --readers N additionally runs 1, 2, 4, .. N simulated readers in parallel (one thread each, jobs from a JobQueue like reader-pool.c)
+//                      in real time and reports how the aggregate tags per minute scale with the amount of readers
+
+#include "main.h"
+#include "mifare-classic.h"
+#include "ntag-216.h"
+#include "ntag-215.h"
+#include "ntag-213.h"
+#include "mifare-ultralight.h"
+#include "type2-tag.h"
+#include "simulator.h"
+#include "transport.h"
+#include "job-queue.h"
+#include "platform.h"
+#include "metrics.h"
+
+#include <fcntl.h>
+#include <time.h>
+
+// BenchCase is one driver function that is run once per simulated tag
+typedef struct BenchCase {
+    const char *name;
+    SimTagType tagType;
+    BOOL (*run)(acr_session *session);
+    BOOL (*check)(const SimReader *reader, acr_session *session);  // looks at the simulated tag after run, NULL: the return value of run is enough
+} BenchCase;
+
+// wrappers so that every driver function has the same signature
+
+static BOOL bench_classic_1k_reset(acr_session *session) {
+    return mifare_classic_reset_card(&MIFARE_CLASSIC_GEOMETRY_1K, KEY_A_DEFAULT, session);
+}
+
+static BOOL bench_classic_1k_read_sector(acr_session *session) {
+    return mifare_classic_read_sector(&MIFARE_CLASSIC_GEOMETRY_1K, 0x01, KEY_A_DEFAULT, session).status != FALSE;
+}
+
+static BOOL bench_classic_1k_uninitialized_to_ndef(acr_session *session) {
+    return mifare_classic_uninitialized_to_ndef(&MIFARE_CLASSIC_GEOMETRY_1K, session);
+}
+
+static BOOL bench_classic_4k_reset(acr_session *session) {
+    return mifare_classic_reset_card(&MIFARE_CLASSIC_GEOMETRY_4K, KEY_A_DEFAULT, session);
+}
+
+static BOOL bench_classic_4k_uninitialized_to_ndef(acr_session *session) {
+    return mifare_classic_uninitialized_to_ndef(&MIFARE_CLASSIC_GEOMETRY_4K, session);
+}
+
+static BOOL bench_classic_mini_uninitialized_to_ndef(acr_session *session) {
+    return mifare_classic_uninitialized_to_ndef(&MIFARE_CLASSIC_GEOMETRY_MINI, session);
+}
+
+static BOOL bench_classic_1k_dump(acr_session *session) {
+    static MifareClassicImage image;
+    image.size = MIFARE_CLASSIC_1K_SIZE;
+    return mifare_classic_dump(&MIFARE_CLASSIC_DEFAULT_KEYSET, &image, NULL, NULL, session);
+}
+
+static BOOL bench_classic_4k_dump(acr_session *session) {
+    static MifareClassicImage image;
+    image.size = MIFARE_CLASSIC_4K_SIZE;
+    return mifare_classic_dump(&MIFARE_CLASSIC_DEFAULT_KEYSET, &image, NULL, NULL, session);
+}
+
+// a typical re-encoding job: three blocks of sector 2 and one block of sector 5 change on an uninitialized tag,
+// current is what mifare_classic_dump returns for a fresh simulated tag (the manufacturer block is never compared against the tag)
+static BOOL bench_classic_1k_write_image(acr_session *session) {
+    static MifareClassicImage target, current;
+    memset(&current, 0, sizeof(current));
+    current.size = MIFARE_CLASSIC_1K_SIZE;
+    current.amountSectors = 16;
+    for (BYTE s = 0; s < current.amountSectors; s++) {
+        memcpy(current.data + mifare_classic_sector_trailer_block(s) * 16, UNINITIALIZED_SECTOR_TRAILER, 16);
+        current.sectorKeys[s].keyType = MIFARE_CLASSIC_KEY_A;
+        memcpy(current.sectorKeys[s].key, KEY_A_DEFAULT, 6);
+        current.sectorsRead |= (uint64_t)1 << s;
+    }
+    target = current;
+    memset(target.data + 0x08 * 16, 0xA5, 3 * 16);
+    memset(target.data + 0x15 * 16, 0x5A, 16);
+
+    return mifare_classic_write_image(NULL, &target, &current, session);
+}
+
+static BOOL bench_ntag_215_fast_read(acr_session *session) {
+    return ntag_215_fast_read(0x00, 0x86, session);
+}
+
+static BOOL bench_ntag_216_fast_read(acr_session *session) {
+    return ntag_216_fast_read(0x00, 0xE6, session);
+}
+
+static BOOL bench_ntag_215_reset_changed_user_data(acr_session *session) {
+    return type2_reset_changed_user_data(&TYPE2_MODEL_NTAG_215, session);
+}
+
+static BOOL bench_ntag_216_reset_changed_user_data(acr_session *session) {
+    return type2_reset_changed_user_data(&TYPE2_MODEL_NTAG_216, session);
+}
+
+static BOOL bench_ultralight_reset_changed_user_data(acr_session *session) {
+    return type2_reset_changed_user_data(&TYPE2_MODEL_ULTRALIGHT_EV1, session);
+}
+
+static BOOL bench_ntag_216_read_pages(acr_session *session) {
+    BYTE pages[TYPE2_MAX_PAGES * TYPE2_PAGE_SIZE];
+    return type2_read_pages(&TYPE2_MODEL_NTAG_216, 0x00, 0xE6, pages, sizeof(pages), session);
+}
+
+// re-provisioning a mostly identical tag: the image differs from the blank tag in the first 4 user pages only (e.g. a short NDEF message)
+static BOOL bench_ntag_216_write_changed_pages(acr_session *session) {
+    BYTE image[(0xE1 - 0x04 + 1) * TYPE2_PAGE_SIZE] = { 0x03, 0x0b, 0xd1, 0x01, 0x07, 0x54, 0x02, 0x65, 0x6e, 0x41, 0x43, 0x52, 0x31, 0x32, 0x32, 0xfe };
+    return type2_write_changed_pages(&TYPE2_MODEL_NTAG_216, image, 0x04, 0xE1, session);
+}
+
+// a complete personalisation of a factory fresh NTAG 215 in one call: NDEF message, password 12 34 56 78 for everything from page 0x10 on,
+// lock bits for pages 0x04 and 0x10 - 0x1F and a locked configuration. the factory password (FF FF FF FF) is needed for CFGLCK, AUTH0 protects CFG1
+static void bench_ntag_215_image(BYTE *image) {
+    static const BYTE Message[4 * TYPE2_PAGE_SIZE] = { 0x03, 0x0b, 0xd1, 0x01, 0x07, 0x54, 0x02, 0x65, 0x6e, 0x41, 0x43, 0x52, 0x31, 0x32, 0x32, 0xfe };
+    static const BYTE Config[5 * TYPE2_PAGE_SIZE] = {
+        0x01, 0x00, 0x00, 0xBD,     // dynamic lock bytes: pages 0x10 - 0x1F
+        0x04, 0x00, 0x00, 0x10,     // CFG0: AUTH0 0x10
+        0x40, 0x05, 0x00, 0x00,     // CFG1: CFGLCK
+        0x12, 0x34, 0x56, 0x78,     // PWD
+        0xAB, 0xCD, 0x00, 0x00,     // PACK
+    };
+    static const BYTE CapabilityContainer[TYPE2_PAGE_SIZE] = { 0xE1, 0x10, 0x3E, 0x00 };
+    memset(image, 0, 135 * TYPE2_PAGE_SIZE);
+    image[0x02 * TYPE2_PAGE_SIZE + 2] = 0x10; // static lock bit L4
+    memcpy(image + 0x03 * TYPE2_PAGE_SIZE, CapabilityContainer, sizeof(CapabilityContainer));
+    memcpy(image + 0x04 * TYPE2_PAGE_SIZE, Message, sizeof(Message));
+    memcpy(image + 0x82 * TYPE2_PAGE_SIZE, Config, sizeof(Config));
+}
+
+static BOOL bench_ntag_215_write_image(acr_session *session) {
+    static const BYTE FactoryPassword[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+    BYTE image[135 * TYPE2_PAGE_SIZE];
+    bench_ntag_215_image(image);
+    return type2_authenticate(&TYPE2_MODEL_NTAG_215, FactoryPassword, NULL, session) &&
+           type2_write_image(&TYPE2_MODEL_NTAG_215, image, NULL, session);
+}
+
+// bench_ntag_215_image_landed reads the image back out of the simulated tag and checks the order of the last writes in the APDU trace:
+// AUTH0 (CFG0) and then CFGLCK (CFG1) have to come after everything else
+static BOOL bench_ntag_215_image_landed(const SimReader *reader, acr_session *session) {
+    BYTE image[135 * TYPE2_PAGE_SIZE];
+    bench_ntag_215_image(image);
+    const BYTE *memory = reader->memory;
+    if ((memcmp(memory + 0x03 * TYPE2_PAGE_SIZE, image + 0x03 * TYPE2_PAGE_SIZE, (0x81 - 0x03 + 1) * TYPE2_PAGE_SIZE) != 0) ||
+        (memcmp(memory + 0x82 * TYPE2_PAGE_SIZE, image + 0x82 * TYPE2_PAGE_SIZE, 5 * TYPE2_PAGE_SIZE) != 0) ||
+        (memory[0x02 * TYPE2_PAGE_SIZE + 2] != 0x10)) {
+        return FALSE;
+    }
+
+    // the last two WRITEs (ff 00 00 00 08 d4 42 a2 page data)
+    const ApduTrace *trace = acr_session_trace(session);
+    int found = 0;
+    BYTE pages[2];
+    for (uint32_t n = 0; (n < trace->count) && (n < APDU_TRACE_ENTRIES) && (found < 2); n++) {
+        const ApduTraceEntry *entry = &trace->entries[(trace->count - 1 - n) % APDU_TRACE_ENTRIES];
+        if ((entry->sendLength == 13) && (entry->send[5] == 0xd4) && (entry->send[6] == 0x42) && (entry->send[7] == 0xa2)) {
+            pages[found++] = entry->send[8];
+        }
+    }
+    return (found == 2) && (pages[0] == 0x84) && (pages[1] == 0x83);
+}
+
+// three blocks of sector 1, once as separate calls (each loads the key and authenticates) and once in one operation held by the caller
+static BOOL bench_classic_1k_write_blocks(acr_session *session) {
+    static const BYTE Data[16] = { 0x01, 0x02, 0x03, 0x04 };
+    for (BYTE block = 0x04; block <= 0x06; block++) {
+        if (!mifare_classic_write_block(&MIFARE_CLASSIC_GEOMETRY_1K, Data, block, KEY_A_DEFAULT, session)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static BOOL bench_classic_1k_write_blocks_batched(acr_session *session) {
+    return ACR_SESSION_OPERATION(session, bench_classic_1k_write_blocks(session));
+}
+
+// a batch on a password protected tag: protect it, then authenticate before each of 8 writes (only the first one sends PWD_AUTH)
+static BOOL bench_ntag_216_authenticated_batch(acr_session *session) {
+    static const BYTE Password[4] = { 0x12, 0x34, 0x56, 0x78 };
+    static const BYTE Pack[2] = { 0xAB, 0xCD };
+    static const BYTE Data[4] = { 0x01, 0x02, 0x03, 0x04 };
+    if (!type2_set_protection(&TYPE2_MODEL_NTAG_216, 0x04, TRUE, Password, Pack, session)) {
+        return FALSE;
+    }
+    for (BYTE page = 0x10; page < 0x18; page++) {
+        if (!type2_authenticate(&TYPE2_MODEL_NTAG_216, Password, Pack, session) || !type2_write_page(&TYPE2_MODEL_NTAG_216, (BYTE *)Data, page, session)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// stands in for a hasher fed as the exchanges arrive
+static BOOL bench_sum_pages(BYTE firstPage, BYTE amountPages, const BYTE *data, void *arg) {
+    (void)firstPage;
+    DWORD *sum = (DWORD *)arg;
+    for (int i = 0; i < amountPages * TYPE2_PAGE_SIZE; i++) {
+        *sum += data[i];
+    }
+    return TRUE;
+}
+
+static BOOL bench_ntag_216_read_pages_with(acr_session *session) {
+    DWORD sum = 0;
+    return type2_read_pages_with(&TYPE2_MODEL_NTAG_216, 0x00, 0xE6, bench_sum_pages, &sum, session);
+}
+
+// the caller does not know the tag type: one GET_VERSION, then the pages of whatever model it is
+static BOOL bench_type2_detected_fast_read(acr_session *session) {
+    const Type2TagModel *model = type2_detect(session);
+    return (model != NULL) && type2_fast_read(model, 0x00, model->amountPages - 1, session);
+}
+
+static const BenchCase BENCH_CASES[] = {
+    { "mifare_classic_read_sector",             SIM_MIFARE_CLASSIC_1K,  bench_classic_1k_read_sector, NULL },
+    { "mifare_classic_reset_card",              SIM_MIFARE_CLASSIC_1K,  bench_classic_1k_reset, NULL },
+    { "mifare_classic_uninitialized_to_ndef",   SIM_MIFARE_CLASSIC_1K,  bench_classic_1k_uninitialized_to_ndef, NULL },
+    { "mifare_classic_dump",                    SIM_MIFARE_CLASSIC_1K,  bench_classic_1k_dump, NULL },
+    { "mifare_classic_write_image (4 blocks)",  SIM_MIFARE_CLASSIC_1K,  bench_classic_1k_write_image, NULL },
+    { "mifare_classic_reset_card",              SIM_MIFARE_CLASSIC_4K,  bench_classic_4k_reset, NULL },
+    { "mifare_classic_uninitialized_to_ndef",   SIM_MIFARE_CLASSIC_4K,  bench_classic_4k_uninitialized_to_ndef, NULL },
+    { "mifare_classic_dump",                    SIM_MIFARE_CLASSIC_4K,  bench_classic_4k_dump, NULL },
+    { "mifare_classic_uninitialized_to_ndef",   SIM_MIFARE_MINI,        bench_classic_mini_uninitialized_to_ndef, NULL },
+    { "ntag_213_reset_user_data",               SIM_NTAG_213,           ntag_213_reset_user_data, NULL },
+    { "ntag_215_reset_user_data",               SIM_NTAG_215,           ntag_215_reset_user_data, NULL },
+    { "type2_reset_changed_user_data",          SIM_NTAG_215,           bench_ntag_215_reset_changed_user_data, NULL },
+    { "type2_write_image (personalisation)",    SIM_NTAG_215,           bench_ntag_215_write_image, bench_ntag_215_image_landed },
+    { "ntag_215_fast_read (entire tag)",        SIM_NTAG_215,           bench_ntag_215_fast_read, NULL },
+    { "ntag_216_reset_user_data",               SIM_NTAG_216,           ntag_216_reset_user_data, NULL },
+    { "type2_reset_changed_user_data",          SIM_NTAG_216,           bench_ntag_216_reset_changed_user_data, NULL },
+    { "type2_write_changed_pages (4 changed)",  SIM_NTAG_216,           bench_ntag_216_write_changed_pages, NULL },
+    { "ntag_216_fast_read (entire tag)",        SIM_NTAG_216,           bench_ntag_216_fast_read, NULL },
+    { "type2_read_pages (entire tag)",          SIM_NTAG_216,           bench_ntag_216_read_pages, NULL },
+    { "type2_read_pages_with (entire tag)",     SIM_NTAG_216,           bench_ntag_216_read_pages_with, NULL },
+    { "mifare_classic_write_block (3 separate)", SIM_MIFARE_CLASSIC_1K, bench_classic_1k_write_blocks, NULL },
+    { "3 x write_block in one operation",       SIM_MIFARE_CLASSIC_1K,  bench_classic_1k_write_blocks_batched, NULL },
+    { "type2_authenticate (batch of 8 writes)", SIM_NTAG_216,           bench_ntag_216_authenticated_batch, NULL },
+    { "type2_fast_read (detected, entire tag)", SIM_NTAG_216,           bench_type2_detected_fast_read, NULL },
+    { "ultralight_reset_user_data",             SIM_ULTRALIGHT_EV1,     ultralight_reset_user_data, NULL },
+    { "type2_reset_changed_user_data",          SIM_ULTRALIGHT_EV1,     bench_ultralight_reset_changed_user_data, NULL },
+    { "ultralight_fast_read",                   SIM_ULTRALIGHT_EV1,     ultralight_fast_read, NULL },
+};
+
+// executeApdu does not print anything, but the drivers still log their steps and the *_fast_read / read_page functions print the pages they read.
+// that output is not what we want to measure, so send it to /dev/null while benchmarking
+static int savedStdout = -1;
+static int savedStderr = -1;
+
+static void bench_silence_output(void) {
+    fflush(stdout);
+    fflush(stderr);
+    savedStdout = dup(STDOUT_FILENO);
+    savedStderr = dup(STDERR_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (devNull >= 0) {
+        dup2(devNull, STDOUT_FILENO);
+        dup2(devNull, STDERR_FILENO);
+        close(devNull);
+    }
+}
+
+static void bench_restore_output(void) {
+    fflush(stdout);
+    fflush(stderr);
+    if (savedStdout >= 0) {
+        dup2(savedStdout, STDOUT_FILENO);
+        close(savedStdout);
+    }
+    if (savedStderr >= 0) {
+        dup2(savedStderr, STDERR_FILENO);
+        close(savedStderr);
+    }
+}
+
+// BenchResult sums up all iterations of one case
+typedef struct BenchResult {
+    uint64_t apdus;
+    uint64_t transactions;
+    uint64_t modelled_us;
+    uint64_t host_us;
+} BenchResult;
+
+// bench_run_case runs benchCase once per iteration, every time on a factory fresh tag (e.g. uninitialized_to_ndef can only run once per tag)
+static BOOL bench_run_case(SimReader *reader, acr_session *session, const BenchCase *benchCase, int iterations, BenchResult *result) {
+    memset(result, 0, sizeof(*result));
+    BOOL success = TRUE;
+
+    bench_silence_output();
+    clock_t start = clock();
+    for (int i = 0; i < iterations && success; i++) {
+        sim_insert_tag(reader, benchCase->tagType, 0x10000000u + (uint32_t)i);
+        acr_session_tag_changed(session); // what reader_session_begin_tag does for every new tag
+        sim_reset_stats(reader);
+
+        success = benchCase->run(session);
+        if (success && (benchCase->check != NULL)) {
+            success = benchCase->check(reader, session);
+        }
+
+        result->apdus += reader->apduCount;
+        result->transactions += reader->transactionCount;
+        result->modelled_us += reader->elapsed_us;
+    }
+    clock_t end = clock();
+    bench_restore_output();
+
+    result->host_us = (uint64_t)((double)(end - start) * 1000000.0 / CLOCKS_PER_SEC);
+    return success;
+}
+
+// -------------------- transaction batching -------------------------------
+
+static const BenchCase BENCH_TRANSACTION_CASES[] = {
+    { "mifare_classic_reset_card",              SIM_MIFARE_CLASSIC_1K,  bench_classic_1k_reset, NULL },
+    { "mifare_classic_reset_card (4k)",         SIM_MIFARE_CLASSIC_4K,  bench_classic_4k_reset, NULL },
+    { "mifare_classic_uninitialized_to_ndef (4k)", SIM_MIFARE_CLASSIC_4K, bench_classic_4k_uninitialized_to_ndef, NULL },
+    { "ntag_216_reset_user_data",               SIM_NTAG_216,           ntag_216_reset_user_data, NULL },
+};
+
+static const char *BENCH_GRANULARITY_NAMES[] = {
+    [ACR_TRANSACTION_NONE] = "none",
+    [ACR_TRANSACTION_PER_SECTOR] = "per sector",
+    [ACR_TRANSACTION_PER_OPERATION] = "per operation",
+};
+
+// bench_transactions compares the transaction granularities: pcsc calls = APDUs + Begin/EndTransaction, pcscd locks = one per APDU
+// outside of a transaction + one per transaction
+static int bench_transactions(SimReader *reader, acr_session *session, int iterations) {
+    AcrTransactionGranularity previous = acr_session_transaction_granularity(session);
+    int failures = 0;
+
+    printf("\nTransaction batching (SCardBeginTransaction / SCardEndTransaction)\n");
+    printf("%-42s %-14s %10s %10s %12s %10s\n", "operation", "transactions", "pcsc calls", "locks", "ms/tag", "saved ms");
+
+    for (size_t c = 0; c < sizeof(BENCH_TRANSACTION_CASES) / sizeof(BENCH_TRANSACTION_CASES[0]); c++) {
+        const BenchCase *benchCase = &BENCH_TRANSACTION_CASES[c];
+        double baselineMs = 0.0;
+
+        for (int g = ACR_TRANSACTION_NONE; g <= ACR_TRANSACTION_PER_OPERATION; g++) {
+            acr_session_set_transaction_granularity(session, (AcrTransactionGranularity)g);
+            BenchResult result;
+            if (!bench_run_case(reader, session, benchCase, iterations, &result)) {
+                printf("%-42s %-14s FAILED\n", benchCase->name, BENCH_GRANULARITY_NAMES[g]);
+                failures++;
+                continue;
+            }
+
+            uint64_t apdus = result.apdus / iterations;
+            uint64_t transactions = result.transactions / iterations;
+            uint64_t locks = (g == ACR_TRANSACTION_NONE) ? apdus : transactions;
+            double msPerTag = (double)result.modelled_us / iterations / 1000.0;
+            if (g == ACR_TRANSACTION_NONE) {
+                baselineMs = msPerTag;
+            }
+            printf("%-42s %-14s %10llu %10llu %12.1f %10.1f\n", benchCase->name, BENCH_GRANULARITY_NAMES[g],
+                (unsigned long long)(apdus + 2 * transactions), (unsigned long long)locks, msPerTag, baselineMs - msPerTag);
+        }
+    }
+
+    acr_session_set_transaction_granularity(session, previous);
+    return failures;
+}
+
+// -------------------- multi-reader scaling -------------------------------
+
+#define BENCH_SCALING_JOBS_PER_READER 8
+
+// a short but realistic job, so that the real time run stays quick
+static const BenchCase BENCH_SCALING_CASE = { "ntag_215_fast_read (entire tag)", SIM_NTAG_215, bench_ntag_215_fast_read, NULL };
+
+// BenchWorker is one simulated reader with its own handle and acr_session, driven by its own thread
+typedef struct BenchWorker {
+    SimReader reader;
+    SCARDHANDLE hCard;
+    acr_session *session;
+    JobQueue *queue;
+    SimTagType tagType;
+    DWORD tags;
+    BOOL success;
+    PlatformThread thread;
+} BenchWorker;
+
+static BOOL bench_job_run(acr_session *session, void *arg) {
+    const BenchCase *benchCase = (const BenchCase *)arg;
+    return benchCase->run(session);
+}
+
+// same loop as reader_pool_worker, with "wait for a tag" replaced by inserting a fresh simulated tag (a simulated tag is there as soon as a job is)
+static void bench_worker(void *arg) {
+    BenchWorker *worker = (BenchWorker *)arg;
+    Job job;
+    while (job_queue_pop(worker->queue, &job)) {
+        sim_insert_tag(&worker->reader, worker->tagType, 0x20000000u + job.id);
+        acr_session_tag_changed(worker->session);
+        if (job.run(worker->session, job.arg)) {
+            worker->tags++;
+        } else {
+            worker->success = FALSE;
+        }
+    }
+}
+
+static int bench_scaling(const BenchCase *benchCase, DWORD maxReaders) {
+    static JobQueue queue;
+    static BenchWorker workers[SIM_MAX_READERS];
+    SimLatencyModel latency = SIM_LATENCY_ACR122U;
+    latency.realtime = TRUE; // threads only help if the reader latency is actually waited for
+
+    printf("\nMulti-reader scaling (real time): %s on %s, %d jobs per reader\n", benchCase->name, sim_tag_name(benchCase->tagType), BENCH_SCALING_JOBS_PER_READER);
+    printf("%8s %8s %12s %10s %10s\n", "readers", "tags", "wall ms", "tags/min", "speedup");
+
+    int failures = 0;
+    double baseline = 0.0;
+    for (DWORD amountReaders = 1; ; amountReaders = (amountReaders * 2 < maxReaders) ? amountReaders * 2 : maxReaders) {
+        job_queue_init(&queue);
+        DWORD amountJobs = amountReaders * BENCH_SCALING_JOBS_PER_READER;
+        for (uint32_t i = 0; i < amountJobs; i++) {
+            Job job = { .run = bench_job_run, .arg = (void *)benchCase, .id = i };
+            job_queue_push(&queue, &job);
+        }
+        job_queue_close(&queue);
+
+        // the simulator registry is not thread-safe, connect every reader before any thread starts
+        for (DWORD r = 0; r < amountReaders; r++) {
+            BenchWorker *worker = &workers[r];
+            sim_reader_init(&worker->reader, &latency);
+            worker->hCard = sim_connect(&worker->reader);
+            worker->session = acr_session_create(worker->hCard);
+            worker->queue = &queue;
+            worker->tagType = benchCase->tagType;
+            worker->tags = 0;
+            worker->success = TRUE;
+        }
+
+        bench_silence_output();
+        uint64_t start = platform_monotonic_us();
+        DWORD started = 0;
+        for (; started < amountReaders; started++) {
+            if (!platform_thread_start(&workers[started].thread, bench_worker, &workers[started])) {
+                break;
+            }
+        }
+        DWORD tags = 0;
+        BOOL success = (started == amountReaders);
+        for (DWORD r = 0; r < started; r++) {
+            platform_thread_join(workers[r].thread);
+            tags += workers[r].tags;
+            success = success && workers[r].success;
+        }
+        uint64_t end = platform_monotonic_us();
+        bench_restore_output();
+
+        for (DWORD r = 0; r < amountReaders; r++) {
+            acr_session_destroy(workers[r].session);
+            sim_disconnect(workers[r].hCard);
+        }
+
+        if (!success || (tags != amountJobs)) {
+            printf("%8lu FAILED\n", (unsigned long)amountReaders);
+            failures++;
+        } else {
+            double tagsPerMinute = (double)tags * 60000000.0 / (double)(end - start);
+            if (amountReaders == 1) {
+                baseline = tagsPerMinute;
+            }
+            printf("%8lu %8lu %12.1f %10.1f %9.2fx\n", (unsigned long)amountReaders, (unsigned long)tags, (double)(end - start) / 1000.0,
+                tagsPerMinute, (baseline > 0.0) ? tagsPerMinute / baseline : 0.0);
+        }
+
+        // checked after failed runs too, otherwise the last amount of readers would be repeated forever
+        if (amountReaders == maxReaders) {
+            break;
+        }
+    }
+
+    return failures;
+}
+
+int main(int argc, char **argv) {
+    int iterations = 20;
+    int scalingReaders = 0;
+    SimLatencyModel latency = SIM_LATENCY_ACR122U;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--realtime") == 0) {
+            latency.realtime = TRUE;
+        } else if (strcmp(argv[i], "--metrics") == 0) {
+            metrics_enable(TRUE);
+        } else if ((strcmp(argv[i], "--readers") == 0) && (i + 1 < argc) && (atoi(argv[i + 1]) > 0) && (atoi(argv[i + 1]) < SIM_MAX_READERS)) {
+            scalingReaders = atoi(argv[++i]);
+        } else if (atoi(argv[i]) > 0) {
+            iterations = atoi(argv[i]);
+        } else {
+            fprintf(stderr, "Usage: %s [iterations] [--realtime] [--metrics] [--readers N] (N < %d)\n", argv[0], SIM_MAX_READERS);
+            return 1;
+        }
+    }
+
+    SimReader reader;
+    sim_reader_init(&reader, &latency);
+    SCARDHANDLE hCard = sim_connect(&reader);
+    setTransport(&SIMULATOR_TRANSPORT);
+
+    acr_session *session = acr_session_create(hCard);
+    if (session == NULL) {
+        return 1;
+    }
+
+    printf("Latency model: %lu us/APDU + %lu us/byte + %lu us/RF exchange + %lu us/authentication + %lu us/pcscd lock, %d iterations per case\n\n",
+        (unsigned long)latency.apdu_us, (unsigned long)latency.byte_us, (unsigned long)latency.rf_us, (unsigned long)latency.auth_us, (unsigned long)latency.lock_us, iterations);
+    printf("%-42s %-22s %8s %12s %10s %12s\n", "operation", "tag", "APDUs", "ms/tag", "tags/min", "host us/tag");
+
+    int failures = 0;
+    for (size_t c = 0; c < sizeof(BENCH_CASES) / sizeof(BENCH_CASES[0]); c++) {
+        const BenchCase *benchCase = &BENCH_CASES[c];
+        BenchResult result;
+        if (!bench_run_case(&reader, session, benchCase, iterations, &result)) {
+            printf("%-42s %-22s FAILED\n", benchCase->name, sim_tag_name(benchCase->tagType));
+            failures++;
+            continue;
+        }
+
+        double msPerTag = (double)result.modelled_us / iterations / 1000.0;
+        double hostUsPerTag = (double)result.host_us / iterations;
+        printf("%-42s %-22s %8llu %12.1f %10.1f %12.1f\n",
+            benchCase->name, sim_tag_name(benchCase->tagType), (unsigned long long)(result.apdus / iterations), msPerTag, 60000.0 / msPerTag, hostUsPerTag);
+    }
+
+    if (metrics_enabled()) {
+        metrics_dump();
+        metrics_enable(FALSE);
+    }
+
+    failures += bench_transactions(&reader, session, iterations);
+
+    acr_session_destroy(session);
+    sim_disconnect(hCard);
+
+    if (scalingReaders > 0) {
+        failures += bench_scaling(&BENCH_SCALING_CASE, (DWORD)scalingReaders);
+    }
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+#include "job-queue.h"
+
+void job_queue_init(JobQueue *queue) {
+    for (uint32_t i = 0; i < JOB_QUEUE_CAPACITY; i++) {
+        queue->cells[i].sequence = i;
+    }
+    queue->enqueuePosition = 0;
+    queue->dequeuePosition = 0;
+    queue->closed = 0;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+// job_queue_push appends a copy of job, returns FALSE if the queue is full (never blocks)
+BOOL job_queue_push(JobQueue *queue, const Job *job) {
+    uint32_t position = __atomic_load_n(&queue->enqueuePosition, __ATOMIC_RELAXED);
+
+    for (;;) {
+        JobQueueCell *cell = &queue->cells[position & (JOB_QUEUE_CAPACITY - 1)];
+        uint32_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        int32_t difference = (int32_t)(sequence - position);
+
+        if (difference == 0) {
+            // cell is free, try to claim it (on failure position is updated to the current value)
+            if (__atomic_compare_exchange_n(&queue->enqueuePosition, &position, position + 1, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                cell->job = *job;
+                __atomic_store_n(&cell->sequence, position + 1, __ATOMIC_RELEASE); // publish to consumers
+                return TRUE;
+            }
+        } else if (difference < 0) {
+            return FALSE; // full: the consumer has not emptied this cell yet
+        } else {
+            position = __atomic_load_n(&queue->enqueuePosition, __ATOMIC_RELAXED); // another producer was faster
+        }
+    }
+}
+
+// job_queue_pop removes the oldest job, returns FALSE if the queue is empty (never blocks)
+BOOL job_queue_pop(JobQueue *queue, Job *job) {
+    uint32_t position = __atomic_load_n(&queue->dequeuePosition, __ATOMIC_RELAXED);
+
+    for (;;) {
+        JobQueueCell *cell = &queue->cells[position & (JOB_QUEUE_CAPACITY - 1)];
+        uint32_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        int32_t difference = (int32_t)(sequence - (position + 1));
+
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(&queue->dequeuePosition, &position, position + 1, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *job = cell->job;
+                __atomic_store_n(&cell->sequence, position + JOB_QUEUE_CAPACITY, __ATOMIC_RELEASE); // hand the cell back to producers
+                return TRUE;
+            }
+        } else if (difference < 0) {
+            return FALSE; // empty
+        } else {
+            position = __atomic_load_n(&queue->dequeuePosition, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// job_queue_close tells consumers that no more jobs will be pushed, they stop once the queue has been drained
+void job_queue_close(JobQueue *queue) {
+    __atomic_store_n(&queue->closed, 1, __ATOMIC_RELEASE);
+}
+
+BOOL job_queue_is_closed(JobQueue *queue) {
+    return __atomic_load_n(&queue->closed, __ATOMIC_ACQUIRE) != 0;
+}
+
+// job_queue_is_drained tells whether the queue is closed and every job has been taken (consumers can stop)
+BOOL job_queue_is_drained(JobQueue *queue) {
+    if (!job_queue_is_closed(queue)) {
+        return FALSE;
+    }
+    // a job pushed right before job_queue_close is guaranteed to be visible once closed is
+    uint32_t position = __atomic_load_n(&queue->dequeuePosition, __ATOMIC_RELAXED);
+    const JobQueueCell *cell = &queue->cells[position & (JOB_QUEUE_CAPACITY - 1)];
+    return (int32_t)(__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) - (position + 1)) < 0;
+}
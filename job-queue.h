@@ -0,0 +1,50 @@
+#ifndef JOB_QUEUE_H
+#define JOB_QUEUE_H
+
+#ifndef COMMON_H
+#include "common.h"
+#endif
+
+#ifndef ACR_SESSION_H
+#include "acr-session.h"
+#endif
+
+// JobQueue is a bounded multi-producer / multi-consumer queue without locks (Dmitry Vyukov's sequence numbered ring buffer).
+// Every cell carries a sequence number that tells producers and consumers whether the cell is theirs to fill / empty,
+// so the only contention is a compare-and-swap on the enqueue or dequeue position. Used by reader-pool.c to hand jobs to
+// one worker thread per reader: a worker that finishes a tag early simply grabs the next job.
+// Atomics are the gcc / clang __atomic builtins (the code base is C99, which has no stdatomic.h).
+
+#define JOB_QUEUE_CAPACITY 1024 // must be a power of two
+#define JOB_QUEUE_CACHE_LINE 64
+
+// Job is one unit of work that is run against whatever tag is lying on the reader of the worker that picked it up
+typedef struct Job {
+    BOOL (*run)(acr_session *session, void *arg);
+    void *arg;
+    uint32_t id;
+} Job;
+
+typedef struct JobQueueCell {
+    uint32_t sequence;
+    Job job;
+} JobQueueCell;
+
+typedef struct JobQueue {
+    JobQueueCell cells[JOB_QUEUE_CAPACITY];
+    // producers and consumers each hammer their own position, keep them on separate cache lines
+    uint32_t enqueuePosition;
+    char padding1[JOB_QUEUE_CACHE_LINE - sizeof(uint32_t)];
+    uint32_t dequeuePosition;
+    char padding2[JOB_QUEUE_CACHE_LINE - sizeof(uint32_t)];
+    uint32_t closed;
+} JobQueue;
+
+void job_queue_init(JobQueue *queue);
+BOOL job_queue_push(JobQueue *queue, const Job *job);
+BOOL job_queue_pop(JobQueue *queue, Job *job);
+void job_queue_close(JobQueue *queue);
+BOOL job_queue_is_closed(JobQueue *queue);
+BOOL job_queue_is_drained(JobQueue *queue);
+
+#endif
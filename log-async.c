@@ -0,0 +1,267 @@
+#define _POSIX_C_SOURCE 200809L // localtime_r and pthreads with -std=c99
+
+#include "log-async.h"
+#include "platform.h"
+
+#include <stdarg.h>
+#include <time.h>
+
+typedef struct LogRecord {
+    const char *file;           // __FILE__, string literals live for the whole program
+    time_t time;
+    int level;
+    int line;
+    char message[LOG_ASYNC_MESSAGE_LENGTH];
+} LogRecord;
+
+// LogRing belongs to at most one thread at a time (inUse), rings are never freed but handed to the next new thread once their owner exits
+typedef struct LogRing {
+    struct LogRing *next;
+    uint32_t inUse;
+    uint32_t head;              // written by the owning thread only
+    uint32_t tail;              // written by the writer thread only
+    uint32_t dropped;
+    LogRecord records[LOG_ASYNC_RING_CAPACITY];
+} LogRing;
+
+static const char *LOG_LEVEL_NAMES[] = { "DEBUG", "INFO", "WARN", "ERROR", "CRITICAL" };
+
+static LogRing *logRings = NULL;    // lock-free list, only ever grows
+static BOOL logRunning = FALSE;
+static BOOL logKeyCreated = FALSE;
+static PlatformThread logWriter;
+static PlatformEvent logWake;       // signalled by log_async_write while the writer is idle, and by log_async_stop
+static BOOL logWriterIdle = FALSE;  // the writer found all rings empty and is about to wait for logWake
+
+// the writer formats into this buffer and writes it to stderr in one go
+static char logBatch[16384];
+static size_t logBatchLength = 0;
+static time_t logCachedSecond = (time_t)-1;
+static char logCachedTimestamp[20];
+
+// ------------------------ Thread ownership -----------------------------
+
+// a thread-exit destructor gives the ring back, that way short lived threads (e.g. bench workers) do not pile up rings
+#ifdef _WIN32
+static DWORD logKey;
+
+static VOID WINAPI log_async_release_ring(PVOID ring) {
+    if (ring != NULL) {
+        __atomic_store_n(&((LogRing *)ring)->inUse, 0, __ATOMIC_RELEASE);
+    }
+}
+
+static BOOL log_async_key_create(void) {
+    logKey = FlsAlloc(log_async_release_ring);
+    return logKey != FLS_OUT_OF_INDEXES;
+}
+#define LOG_ASYNC_KEY_GET()         ((LogRing *)FlsGetValue(logKey))
+#define LOG_ASYNC_KEY_SET(ring)     FlsSetValue(logKey, (ring))
+#else
+static pthread_key_t logKey;
+
+static void log_async_release_ring(void *ring) {
+    __atomic_store_n(&((LogRing *)ring)->inUse, 0, __ATOMIC_RELEASE);
+}
+
+static BOOL log_async_key_create(void) {
+    return pthread_key_create(&logKey, log_async_release_ring) == 0;
+}
+#define LOG_ASYNC_KEY_GET()         ((LogRing *)pthread_getspecific(logKey))
+#define LOG_ASYNC_KEY_SET(ring)     pthread_setspecific(logKey, (ring))
+#endif
+
+// log_async_thread_ring returns the ring of the calling thread, it claims a released ring or allocates a new one on first use
+static LogRing *log_async_thread_ring(void) {
+    LogRing *ring = LOG_ASYNC_KEY_GET();
+    if (ring != NULL) {
+        return ring;
+    }
+
+    for (ring = __atomic_load_n(&logRings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+        uint32_t expected = 0;
+        if (__atomic_compare_exchange_n(&ring->inUse, &expected, 1, FALSE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            LOG_ASYNC_KEY_SET(ring);
+            return ring;
+        }
+    }
+
+    ring = calloc(1, sizeof(LogRing));
+    if (ring == NULL) {
+        return NULL;
+    }
+    ring->inUse = 1;
+    ring->next = __atomic_load_n(&logRings, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&logRings, &ring->next, ring, TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        // ring->next was updated to the current list head, try again
+    }
+    LOG_ASYNC_KEY_SET(ring);
+
+    return ring;
+}
+
+// ------------------------ Formatting -----------------------------
+
+static const char *log_async_level_name(int level) {
+    return ((level >= LOG_LEVEL_DEBUG) && (level <= LOG_LEVEL_CRITICAL)) ? LOG_LEVEL_NAMES[level] : "?";
+}
+
+static void log_async_format_time(time_t t, char *timestr, size_t size) {
+    struct tm lt;
+#ifdef _WIN32
+    localtime_s(&lt, &t);
+#else
+    localtime_r(&t, &lt);
+#endif
+    strftime(timestr, size, "%Y-%m-%d %H:%M:%S", &lt);
+}
+
+static void log_async_flush_batch(void) {
+    if (logBatchLength > 0) {
+        fwrite(logBatch, 1, logBatchLength, stderr);
+        fflush(stderr);
+        logBatchLength = 0;
+    }
+}
+
+static void log_async_append(time_t t, int level, const char *file, int line, const char *message) {
+    // localtime + strftime only once per second instead of once per message
+    if (t != logCachedSecond) {
+        log_async_format_time(t, logCachedTimestamp, sizeof(logCachedTimestamp));
+        logCachedSecond = t;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        size_t available = sizeof(logBatch) - logBatchLength;
+        int written = snprintf(logBatch + logBatchLength, available, "[%s] [%s] [%s:%d] %s\n",
+            logCachedTimestamp, log_async_level_name(level), file, line, message);
+        if ((written >= 0) && ((size_t)written < available)) {
+            logBatchLength += (size_t)written;
+            return;
+        }
+        // did not fit, write out what we have and try again with an empty batch
+        log_async_flush_batch();
+    }
+}
+
+// log_async_drain moves everything that is currently in the rings to stderr, returns how many records were written
+static size_t log_async_drain(void) {
+    size_t amount = 0;
+
+    for (LogRing *ring = __atomic_load_n(&logRings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+        uint32_t tail = ring->tail;
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        for (; tail != head; tail++) {
+            const LogRecord *record = &ring->records[tail & (LOG_ASYNC_RING_CAPACITY - 1)];
+            log_async_append(record->time, record->level, record->file, record->line, record->message);
+            amount++;
+        }
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+
+        uint32_t dropped = __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+        if (dropped > 0) {
+            char message[64];
+            snprintf(message, sizeof(message), "Dropped %u log messages (log ring was full)", dropped);
+            log_async_append(time(NULL), LOG_LEVEL_WARN, __FILE__, __LINE__, message);
+        }
+    }
+
+    log_async_flush_batch();
+    return amount;
+}
+
+// log_async_wake_writer is called after a record was published, only the first message after the writer went idle signals it.
+// the seq_cst fence pairs with the one in log_async_writer: either the writer sees the new head or this sees logWriterIdle
+static void log_async_wake_writer(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&logWriterIdle, __ATOMIC_RELAXED) && __atomic_exchange_n(&logWriterIdle, FALSE, __ATOMIC_ACQ_REL)) {
+        platform_event_signal(&logWake);
+    }
+}
+
+static void log_async_writer(void *arg) {
+    (void)arg;
+    while (__atomic_load_n(&logRunning, __ATOMIC_ACQUIRE)) {
+        if (log_async_drain() > 0) {
+            continue;
+        }
+        // announce that we are going to sleep, then look once more: a message published before the announcement was seen would be missed otherwise
+        __atomic_store_n(&logWriterIdle, TRUE, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if ((log_async_drain() == 0) && __atomic_load_n(&logRunning, __ATOMIC_ACQUIRE)) {
+            platform_event_wait(&logWake, INFINITE);
+        }
+        __atomic_store_n(&logWriterIdle, FALSE, __ATOMIC_RELAXED);
+    }
+}
+
+// ------------------------ Public API -----------------------------
+
+// log_async_start starts the background writer, returns FALSE (and keeps logging synchronously) if that is not possible
+int log_async_start(void) {
+    if (__atomic_load_n(&logRunning, __ATOMIC_ACQUIRE)) {
+        return TRUE;
+    }
+    if (!logKeyCreated) {
+        if (!log_async_key_create()) {
+            return FALSE;
+        }
+        logKeyCreated = TRUE;
+    }
+
+    if (!platform_event_init(&logWake)) {
+        return FALSE;
+    }
+    __atomic_store_n(&logRunning, TRUE, __ATOMIC_RELEASE);
+    if (!platform_thread_start(&logWriter, log_async_writer, NULL)) {
+        __atomic_store_n(&logRunning, FALSE, __ATOMIC_RELEASE);
+        platform_event_destroy(&logWake);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+// log_async_stop writes out everything that is still queued and switches back to synchronous logging (suitable for atexit),
+// threads that are still logging while this runs may lose their last messages, so join them first
+void log_async_stop(void) {
+    if (!__atomic_load_n(&logRunning, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    __atomic_store_n(&logRunning, FALSE, __ATOMIC_RELEASE);
+    platform_event_signal(&logWake);
+    platform_thread_join(logWriter);
+    platform_event_destroy(&logWake);
+    log_async_drain();
+}
+
+// log_async_write is what the LOG_* macros expand to, do not call directly
+void log_async_write(int level, const char *file, int line, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+
+    LogRing *ring = __atomic_load_n(&logRunning, __ATOMIC_ACQUIRE) ? log_async_thread_ring() : NULL;
+    if (ring == NULL) {
+        char timestr[20];
+        char message[LOG_ASYNC_MESSAGE_LENGTH];
+        log_async_format_time(time(NULL), timestr, sizeof(timestr));
+        vsnprintf(message, sizeof(message), fmt, args);
+        fprintf(stderr, "[%s] [%s] [%s:%d] %s\n", timestr, log_async_level_name(level), file, line, message);
+    } else {
+        uint32_t head = ring->head;
+        if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= LOG_ASYNC_RING_CAPACITY) {
+            __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+        } else {
+            LogRecord *record = &ring->records[head & (LOG_ASYNC_RING_CAPACITY - 1)];
+            record->file = file;
+            record->time = time(NULL);
+            record->level = level;
+            record->line = line;
+            vsnprintf(record->message, sizeof(record->message), fmt, args);
+            __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+        }
+        log_async_wake_writer();
+    }
+
+    va_end(args);
+}
@@ -0,0 +1,29 @@
+#ifndef LOG_ASYNC_H
+#define LOG_ASYNC_H
+
+#include <stdint.h>
+
+// Asynchronous backend of the LOG_* macros in logging.c.
+// Every thread that logs owns a single-producer / single-consumer ring of fixed size records, so writing a message costs
+// one vsnprintf plus a release store and never touches stderr. A background thread drains all rings, formats the
+// timestamp (cached, it only changes once per second) and writes whole batches to stderr. While all rings are empty it sleeps
+// until the next message arrives, waking it costs the logging thread one event signal per batch instead of one per message.
+// Before log_async_start and after log_async_stop messages are written synchronously.
+// Per-thread order is preserved, lines of different threads may interleave in a slightly different order than they were logged.
+// A full ring drops messages instead of blocking the caller, the amount of dropped messages is reported by the writer.
+
+#define LOG_LEVEL_DEBUG     0
+#define LOG_LEVEL_INFO      1
+#define LOG_LEVEL_WARN      2
+#define LOG_LEVEL_ERROR     3
+#define LOG_LEVEL_CRITICAL  4
+#define LOG_LEVEL_OFF       5
+
+#define LOG_ASYNC_RING_CAPACITY 512     // records per thread, must be a power of two
+#define LOG_ASYNC_MESSAGE_LENGTH 224    // longer messages are truncated
+
+int log_async_start(void);
+void log_async_stop(void);
+void log_async_write(int level, const char *file, int line, const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+
+#endif
@@ -2,21 +2,50 @@
 #define LOGGING_C
 
 #include <stdio.h>
-#include <time.h>
-
-#define LOG_FMT(level, fmt, ...) \
-    do { \
-        time_t t = time(NULL); \
-        struct tm *lt = localtime(&t); \
-        char timestr[20]; \
-        strftime(timestr, sizeof(timestr), "%Y-%m-%d %H:%M:%S", lt); \
-        fprintf(stderr, "[%s] [%s] [%s:%d] " fmt "\n", timestr, level, __FILE__, __LINE__, ##__VA_ARGS__); \
-    } while (0)
-
-#define LOG_DEBUG(fmt, ...)   	LOG_FMT("DEBUG", fmt, ##__VA_ARGS__)
-#define LOG_INFO(fmt, ...)    	LOG_FMT("INFO", fmt, ##__VA_ARGS__)
-#define LOG_WARN(fmt, ...)    	LOG_FMT("WARN", fmt, ##__VA_ARGS__)
-#define LOG_ERROR(fmt, ...)   	LOG_FMT("ERROR", fmt, ##__VA_ARGS__)
-#define LOG_CRITICAL(fmt, ...)	LOG_FMT("CRITICAL", fmt, ##__VA_ARGS__)
-
-#endif
\ No newline at end of file
+
+#include "log-async.h"
+
+// LOG_LEVEL is the lowest level that is compiled in (e.g. make LOG_LEVEL=2 keeps only WARN and above),
+// calls below it compile to nothing: their arguments are still type checked but never evaluated
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+// messages are queued and written by a background thread once log_async_start was called (see log-async.h)
+#define LOG_FMT(level, fmt, ...) log_async_write(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+static inline void log_discard(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static inline void log_discard(const char *fmt, ...) { (void)fmt; }
+#define LOG_DISCARD(fmt, ...) do { if (0) log_discard(fmt, ##__VA_ARGS__); } while (0)
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(fmt, ...)   	LOG_FMT(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...)   	LOG_DISCARD(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(fmt, ...)    	LOG_FMT(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...)    	LOG_DISCARD(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(fmt, ...)    	LOG_FMT(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN(fmt, ...)    	LOG_DISCARD(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(fmt, ...)   	LOG_FMT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...)   	LOG_DISCARD(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_CRITICAL
+#define LOG_CRITICAL(fmt, ...)	LOG_FMT(LOG_LEVEL_CRITICAL, fmt, ##__VA_ARGS__)
+#else
+#define LOG_CRITICAL(fmt, ...)	LOG_DISCARD(fmt, ##__VA_ARGS__)
+#endif
+
+#endif
@@ -65,13 +65,21 @@
     // You can verify that it works via 'sudo apt install clangd' followed by 'clangd --check=main.c'
 
 #include "main.h"
-#include "mifare-classic-1k.h"
-#include "mifare-classic-4k.h"
+#include "mifare-classic.h"
+#include "mifare-classic-resolver.h"
 #include "ndef.h"
 #include "ntag-216.h"
 #include "ntag-215.h"
 #include "ntag-213.h"
 #include "mifare-ultralight.h"
+#include "type2-tag.h"
+#include "transport.h"
+#include "apdu-trace.h"
+#include "metrics.h"
+#include "platform.h"
+#include "presence.h"
+#include "reader-session.h"
+#include "reader-pool.h"
 
 #include "logging.c"
 
@@ -91,6 +99,27 @@ LONG getAvailableReaders(SCARDCONTEXT hContext, char *mszReaders, DWORD *dwReade
     return lRet;
 }
 
+// findAcr122Readers copies the names of (at most maxReaders) connected ACR122 readers to readers, returns how many were found
+DWORD findAcr122Readers(SCARDCONTEXT hContext, char readers[][256], DWORD maxReaders) {
+    char mszReaders[4096];
+    DWORD dwReaders = sizeof(mszReaders);
+    if (getAvailableReaders(hContext, mszReaders, &dwReaders) != SCARD_S_SUCCESS) {
+        return 0;
+    }
+
+    // mszReaders is a multi-string: "reader1\0reader2\0\0"
+    DWORD amount = 0;
+    for (const char *reader = mszReaders; (*reader != '\0') && (amount < maxReaders); reader += strlen(reader) + 1) {
+        if (containsSubstring(reader, "ACR122")) {
+            strncpy(readers[amount], reader, 255);
+            readers[amount][255] = '\0';
+            amount++;
+        }
+    }
+
+    return amount;
+}
+
 LONG connectToReader(SCARDCONTEXT hContext, const char *reader, SCARDHANDLE *hCard, DWORD *dwActiveProtocol, BOOL directConnect) {
     LONG lRet;
 
@@ -106,45 +135,47 @@ LONG connectToReader(SCARDCONTEXT hContext, const char *reader, SCARDHANDLE *hCa
     return lRet;
 }
 
-// executes command and returns the amount of bytes that the response contains
-ApduResponse executeApdu(SCARDHANDLE hCard, BYTE *pbSendBuffer, DWORD dwSendLength, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize) {
-    // first reset first 256 bytes of response buffer to all zeroes (to avoid that 90 00 from some previous command is later read and confused)
-    resetBuffer256(pbRecvBuffer);
-
-    // this took me long to figure out (part 1): i want to always remember the size of the array that holds the response. but SCardTransmit modifies the value of pbRecvBufferSize to the amount of bytes of the response. thats why we can lose the information how big our buffer is. this can lead to nasty bugs (e.g. you just once forget to update pbRecvBufferSize to the amount of bytes of the expected response and then u get UB due to buffer overflow. so safer is to just always reset to actual buffer size)
-    DWORD pbRecvBufferSizeBackup = *pbRecvBufferSize;
-
-    LONG lRet = SCardTransmit(hCard, SCARD_PCI_T1, pbSendBuffer, dwSendLength, NULL, pbRecvBuffer, pbRecvBufferSize);
-    // also print reply
-    if (lRet == SCARD_S_SUCCESS) {
-        // print which command you sent
-        printf("> ");
-        printHex(pbSendBuffer, dwSendLength);
+// isInCommunicateThru tells whether an APDU is a command that the PN532 forwards to the tag as it is (ff 00 00 00 Lc d4 42 ..)
+static BOOL isInCommunicateThru(const BYTE *pbSendBuffer, DWORD dwSendLength) {
+    return (dwSendLength >= 7) && (pbSendBuffer[0] == 0xff) && (pbSendBuffer[1] == 0x00) && (pbSendBuffer[5] == 0xd4) && (pbSendBuffer[6] == 0x42);
+}
 
-        // print what you received
-        printf("< ");
-        printHex(pbRecvBuffer, *pbRecvBufferSize);
+// executes command and returns the amount of bytes that the response contains (the response itself is in acr_session_recv_buffer(session))
+// this is the hot path of every driver: nothing is printed here, every exchange is recorded in the APDU trace of the session instead (see apdu_trace_dump)
+// the response buffer is not reset between APDUs, so callers must validate replies with isSuccessResponse (which checks amount_response_bytes)
+ApduResponse executeApdu(acr_session *session, BYTE *pbSendBuffer, DWORD dwSendLength) {
+    BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
+    // SCardTransmit overwrites the size with the amount of bytes received, a local copy means the buffer size can never get lost between calls
+    DWORD pbRecvBufferSize = ACR_SESSION_RECV_BUFFER_SIZE;
+
+    BOOL timed = metrics_enabled();
+    uint64_t start_us = timed ? platform_monotonic_us() : 0;
+
+    // the transport is pcsc unless it has been swapped out (e.g. for the tag simulator)
+    LONG lRet = acr_session_transport(session)->transmit(acr_session_handle(session), pbSendBuffer, dwSendLength, pbRecvBuffer, &pbRecvBufferSize);
+    if (timed) {
+        metrics_record_apdu(metrics_classify_apdu(pbSendBuffer, dwSendLength), platform_monotonic_us() - start_us);
+    }
+    apdu_trace_record(acr_session_trace(session), pbSendBuffer, dwSendLength, pbRecvBuffer, pbRecvBufferSize, lRet);
+    acr_session_record_apdu(session, dwSendLength, pbRecvBufferSize, lRet);
 
-    } else {
-        //printf("%08x\n", lRet);
-        printf("%08lx\n", lRet);
+    // a tag drops its mifare classic authentication on any error, a transport error might even mean that the reader lost its key slots
+    if (lRet != SCARD_S_SUCCESS) {
+        acr_session_forget_authentication(session);
+        acr_session_forget_key_slots(session);
+    } else if ((pbRecvBufferSize < 2) || (pbRecvBuffer[pbRecvBufferSize - 2] != 0x90) || (pbRecvBuffer[pbRecvBufferSize - 1] != 0x00)) {
+        acr_session_forget_authentication(session);
+    } else if (isInCommunicateThru(pbSendBuffer, dwSendLength) && ((pbRecvBufferSize < 3 + 2) || (pbRecvBuffer[2] != PN532_STATUS_OK))) {
+        // the reader answers 90 00 even if the tag refused the command (NAK), the tag dropped its authentication all the same
+        acr_session_forget_authentication(session);
     }
 
-    LOG_DEBUG("Response status: %lu (0 means success)\n", lRet);
-    LOG_DEBUG("Response size: %lu bytes\n", *pbRecvBufferSize); // linux wants %lu, macos wants %u. just use either and ignore warning lul
-    
-    // return both status and length of response
-    // ApduResponse response;
-    // response.status = lRet;
-    // response.amount_response_bytes = *pbRecvBufferSize;
+    // return both status and length of response (a failed transmit did not receive anything)
     ApduResponse response = {
         .status = lRet,
-        .amount_response_bytes = *pbRecvBufferSize
+        .amount_response_bytes = (lRet == SCARD_S_SUCCESS) ? (LONG)pbRecvBufferSize : 0
     };
 
-    // this took me long to figure out (part 2): i want to always retain the constant buffer size in this variable
-    *pbRecvBufferSize = pbRecvBufferSizeBackup;
-
     return response;
 }
 
@@ -160,7 +191,12 @@ LONG disableBuzzer(SCARDCONTEXT hContext, const char *reader, SCARDHANDLE *hCard
     BYTE pbSendBuffer[] = { 0xFF, 0x00, 0x52, 0x00, 0x00 };
     DWORD cbRecvLength = 16;
 
-    LONG result = SCardControl(*hCard, SCARD_CTL_CODE(3500), pbSendBuffer, sizeof(pbSendBuffer), pbRecvBuffer, *pbRecvBufferSize, &cbRecvLength); //  3500 escape code defined by microsoft, 2079 escape code defined by ACS, i tried both and only 3500 works on every OS
+    BOOL timed = metrics_enabled();
+    uint64_t start_us = timed ? platform_monotonic_us() : 0;
+    LONG result = getTransport()->control(*hCard, SCARD_CTL_CODE(3500), pbSendBuffer, sizeof(pbSendBuffer), pbRecvBuffer, *pbRecvBufferSize, &cbRecvLength); //  3500 escape code defined by microsoft, 2079 escape code defined by ACS, i tried both and only 3500 works on every OS
+    if (timed) {
+        metrics_record_apdu(APDU_CLASS_ESCAPE, platform_monotonic_us() - start_us);
+    }
 
     return result;
 }
@@ -172,32 +208,25 @@ void disconnectReader(SCARDHANDLE hCard, SCARDCONTEXT hContext) {
 
 // -------------------- General Functions that interact with various tags -------------------------------
 
-LONG getUID(SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize, BOOL printResult) {
+// getUID reads the UID of the tag and caches it in the session (see acr_session_uid)
+LONG getUID(acr_session *session, BOOL printResult) {
+    BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
     LOG_INFO("Will now try to determine UID");
     // Define the GET UID APDU command (PC/SC standard for many cards)
     BYTE pbSendBuffer[] = { 0xFF, 0xCA, 0x00, 0x00, 0x00 }; // if u change last byte to e.g. 0x04 then u only get first 4 bytes of UID
-    ApduResponse response = executeApdu(hCard, pbSendBuffer, sizeof(pbSendBuffer), pbRecvBuffer, pbRecvBufferSize);
+    ApduResponse response = executeApdu(session, pbSendBuffer, sizeof(pbSendBuffer));
 
-    // ensure 90 00 success is returned by acr122u ()
-    if ((!((pbRecvBuffer[4] == 0x90 && pbRecvBuffer[5] == 0x00) ||   // UID of length 4: single UID
-         (pbRecvBuffer[7] == 0x90 && pbRecvBuffer[8] == 0x00)  ||   // UID of length 7: double UID
-         (pbRecvBuffer[10] == 0x90 && pbRecvBuffer[11] == 0x00)     // UID of length 10: oh baby a triple oh yeah UID
-         )) || (response.status != SCARD_S_SUCCESS)) {      
+    // ensure 90 00 success is returned by acr122u (UID of length 4: single UID, 7: double UID, 10: oh baby a triple oh yeah UID)
+    LONG uidLength = response.amount_response_bytes - 2;
+    if (!((uidLength == 4) || (uidLength == 7) || (uidLength == 10)) || !isSuccessResponse(response, pbRecvBuffer, uidLength)) {
         return ACR_90_00_FAILURE;
     }
+    acr_session_set_uid(session, pbRecvBuffer, (BYTE)uidLength);
 
     if (printResult) {
-        // success: now print UID
+        // success: now print UID (no need to print success code 90 00)
         printf("Detected UID: ");
-        for (DWORD i = 0; i < *pbRecvBufferSize - 2; i++) { // -2 because no need to print success code 90 00
-            // avoid printing entire buffer of zeroes, but check for 90 00 only if i+1 is in bounds
-            if ((i + 1 < *pbRecvBufferSize) &&
-                (pbRecvBuffer[i] == 0x90) &&
-                (pbRecvBuffer[i + 1] == 0x00)) {
-                printf("\n");
-                return response.status;
-            }
-
+        for (LONG i = 0; i < uidLength; i++) {
             printf("%02X ", pbRecvBuffer[i]);
         }
         printf("\n");
@@ -208,17 +237,20 @@ LONG getUID(SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize, BOOL
 }
 
 // getATS_14443A sends a RATS (Request for Answer To Select) to the tag (afaik only stuff like desfire, ntag 424 dna, smartMX and some java cards even support this)
-ApduResponse getATS_14443A(SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize, char *tagName) {
+ApduResponse getATS_14443A(acr_session *session, char *tagName) {
+    BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
     LOG_INFO("Will now try to determine ATS");
     BYTE pbSendBuffer[] = { 0xFF, 0xCA, 0x01, 0x00, 0x00 };
-    ApduResponse response = executeApdu(hCard, pbSendBuffer, sizeof(pbSendBuffer), pbRecvBuffer, pbRecvBufferSize);
+    ApduResponse response = executeApdu(session, pbSendBuffer, sizeof(pbSendBuffer));
 
-    if ((pbRecvBuffer[0] == 0x6A) && (pbRecvBuffer[1] == 0x81)) {
+    if ((response.amount_response_bytes == 2) && (pbRecvBuffer[0] == 0x6A) && (pbRecvBuffer[1] == 0x81)) {
         LOG_WARN("Accessing ATS of this tag type is currently not supported by this program\n");
     }
 
     // identify Mifare Desfire EV3 8k
-    if ((pbRecvBuffer[0] == 0x06) && (pbRecvBuffer[1] == 0x75) && (pbRecvBuffer[2] == 0x77) && (pbRecvBuffer[3] == 0x81) && (pbRecvBuffer[4] == 0x02) && (pbRecvBuffer[5] == 0x80)) {
+    if (response.amount_response_bytes < 6) {
+        // nothing to identify
+    } else if ((pbRecvBuffer[0] == 0x06) && (pbRecvBuffer[1] == 0x75) && (pbRecvBuffer[2] == 0x77) && (pbRecvBuffer[3] == 0x81) && (pbRecvBuffer[4] == 0x02) && (pbRecvBuffer[5] == 0x80)) {
         LOG_INFO("I now know for sure that your tag is: Desfire EV3");
         // update stored tag name
         strncpy(tagName, "Mifare Desfire EV3 8k", 99); // i dont own enough tags to tell whether that decides just desfire, or desfire ev3, or desfire ev3 8k
@@ -229,18 +261,21 @@ ApduResponse getATS_14443A(SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvB
         // update stored tag name
         strncpy(tagName, "NTAG 424 DNA TT", 99);
     }
+    acr_session_set_tag_name(session, tagName);
 
     printf("\n");
     return response;
 }
 
-LONG getStatus(SCARDHANDLE *hCard, char *mszReaders, DWORD dwState, DWORD dwReaders, DWORD *dwActiveProtocol, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize, BOOL printResult, char *tagName) {
+LONG getStatus(acr_session *session, char *mszReaders, DWORD dwState, DWORD dwReaders, DWORD *dwActiveProtocol, BOOL printResult, char *tagName) {
+    BYTE *pbRecvBuffer = acr_session_recv_buffer_large(session);
+    DWORD pbRecvBufferSize = ACR_SESSION_RECV_BUFFER_LARGE_SIZE;
     LOG_INFO("Will now try to determine which model your tag is");
-    LONG lRet = SCardStatus(*hCard, mszReaders, &dwReaders, &dwState, dwActiveProtocol, pbRecvBuffer, pbRecvBufferSize);
+    LONG lRet = SCardStatus(acr_session_handle(session), mszReaders, &dwReaders, &dwState, dwActiveProtocol, pbRecvBuffer, &pbRecvBufferSize);
     if ((lRet == SCARD_S_SUCCESS) && printResult) {
         // success: now print status
         printf("Detected tag type: ");
-        for (DWORD i = 0; i < *pbRecvBufferSize - 2; i++) { // -2 because no need to print success code 90 00
+        for (DWORD i = 0; i < pbRecvBufferSize - 2; i++) { // -2 because no need to print success code 90 00
             printf("%02X ", pbRecvBuffer[i]);
         }
         printf("\n");
@@ -262,7 +297,7 @@ LONG getStatus(SCARDHANDLE *hCard, char *mszReaders, DWORD dwState, DWORD dwRead
             strncpy(tagName, "Mifare Classic 4k", 99);
         } else if ((pbRecvBuffer[13] == 0x00) && (pbRecvBuffer[14] == 0x03)) {
             printf("Identified tag as: Mifare Ultralight or NTAG2xx\n");
-            strncpy(tagName, "Mifare Ultralight or NTAG2xx", 99);
+            strncpy(tagName, TYPE2_TAG_NAME_UNDETERMINED, 99); // type2_detect can tell them apart
         } else if ((pbRecvBuffer[13] == 0x00) && (pbRecvBuffer[14] == 0x26)) {
             printf("Identified tag as: Mifare Mini\n");
             strncpy(tagName, "Mifare Mini", 99);
@@ -287,12 +322,38 @@ LONG getStatus(SCARDHANDLE *hCard, char *mszReaders, DWORD dwState, DWORD dwRead
             LOG_ERROR("Failed to identify the tag\n");
             strncpy(tagName, "UNIDENTIFIED TAG", 99);
         }
+        acr_session_set_tag_name(session, tagName);
     }
 
     printf("\n");
     return lRet;
 }
 
+// reselectTag selects the tag on the reader again (InListPassiveTarget). A tag that refused a command (Type 2 NAK, failed mifare classic authentication)
+// halts and answers nothing until then. every authentication is gone afterwards, the key slots of the reader stay
+BOOL reselectTag(acr_session *session) {
+    BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
+
+    // ff 00 00 00 04 (communicate with pn532 and 4 byte command will follow)
+    //      d4 (data exchange command)
+    //      4a (InListPassiveTarget)
+    //      01 (at most one target) 00 (106 kbps type A)
+    // Response:
+    //      d5 4b 01 (one target found)
+    //      target number, SENS_RES (2 bytes), SEL_RES, UID length, UID
+    //      90 00
+    BYTE APDU_Select[9] = { 0xff, 0x00, 0x00, 0x00, 0x04, 0xd4, 0x4a, 0x01, 0x00 };
+    ApduResponse response = executeApdu(session, APDU_Select, sizeof(APDU_Select));
+    acr_session_forget_authentication(session);
+    LONG length = response.amount_response_bytes;
+    if ((response.status != SCARD_S_SUCCESS) || (length < 3 + 2) || (pbRecvBuffer[0] != 0xd5) || (pbRecvBuffer[1] != 0x4b) || (pbRecvBuffer[2] != 0x01) ||
+        (pbRecvBuffer[length - 2] != 0x90) || (pbRecvBuffer[length - 1] != 0x00)) {
+        LOG_WARN("Could not select the tag again (did it leave the reader?)");
+        return FALSE;
+    }
+    return TRUE;
+}
+
 // -------------------- Helper functions -------------------------------------------------------
 
 BOOL containsSubstring(const char *string, const char *substring) {
@@ -325,6 +386,20 @@ BOOL containsSubstring(const char *string, const char *substring) {
     return FALSE;
 }
 
+// isSuccessResponse checks that the reply to an APDU consists of exactly dataLength bytes followed by 90 00
+// (looking at the length instead of just at pbRecvBuffer[dataLength] ensures that a stale 90 00 from some previous, longer response is never confused with success)
+BOOL isSuccessResponse(ApduResponse response, const BYTE *pbRecvBuffer, LONG dataLength) {
+    return (response.status == SCARD_S_SUCCESS) &&
+           (response.amount_response_bytes == dataLength + 2) &&
+           (pbRecvBuffer[dataLength] == 0x90) &&
+           (pbRecvBuffer[dataLength + 1] == 0x00);
+}
+
+// isTagSuccessResponse is isSuccessResponse for InCommunicateThru (d4 42): dataLength includes d5 43 <status>, and the status has to be PN532_STATUS_OK
+BOOL isTagSuccessResponse(ApduResponse response, const BYTE *pbRecvBuffer, LONG dataLength) {
+    return isSuccessResponse(response, pbRecvBuffer, dataLength) && (dataLength >= 3) && (pbRecvBuffer[2] == PN532_STATUS_OK);
+}
+
 // printHex prints bytes as hex
 void printHex(LPCBYTE pbData, DWORD cbData) {
     for (DWORD i = 0; i < cbData; i++) {
@@ -386,6 +461,8 @@ BOOL is_byte_in_array(BYTE value, const BYTE *array, size_t size) {
 
 // -------------------------------------------------------
 
+// bench.c brings its own main(), it links against this file compiled with -DACR122U_NO_MAIN
+#ifndef ACR122U_NO_MAIN
 int main(void) {
     SCARDCONTEXT hContext;
     SCARDHANDLE hCard = 0;
@@ -393,16 +470,19 @@ int main(void) {
     char mszReaders[1024];
     DWORD dwReaders = sizeof(mszReaders);
 
-    BYTE pbRecvBuffer[256] = {0}; // PN532 can only transfer 256 bytes at once (page 29 of PN532 application note)
+    BYTE pbRecvBuffer[256] = {0}; // only for reader configuration, everything that talks to the tag uses the buffers of the acr_session
     DWORD pbRecvBufferSize = sizeof(pbRecvBuffer);
-
-    BYTE pbRecvBufferLarge[2048] = {0};
-    DWORD pbRecvBufferSizeLarge = sizeof(pbRecvBufferLarge);
     
     DWORD dwState = SCARD_POWERED; // TODO: can u dynamically request the actual state somehow?
 
     char connectedTag[100]; // will later hold e.g. "Mifare Classic 4k", just pre-alloc 100 bytes for the name (and 100% reason to remember the name)
 
+    // logging from here on happens on a background thread, atexit flushes whatever is still queued
+    log_async_start();
+    atexit(log_async_stop);
+
+    metrics_enable(TRUE); // latency histograms, printed at the end (see metrics_dump)
+
     // Establish context
     LONG lRet = SCardEstablishContext(SCARD_SCOPE_SYSTEM, NULL, NULL, &hContext);
     if (lRet != SCARD_S_SUCCESS) {
@@ -422,23 +502,25 @@ int main(void) {
         return 1;
     }
 
-    // Print connected readers and select the first one
+    // Print connected readers and select the first ACR122U
     LOG_INFO("Available Smart Card Readers:");
-    char *reader = mszReaders;
-    if (*reader == '\0') {
+    if (*mszReaders == '\0') {
         LOG_CRITICAL("No readers found.\n");
         SCardReleaseContext(hContext);
         return 1;
     }
-    printf("\t- %s\n", reader);
+    for (const char *listedReader = mszReaders; *listedReader != '\0'; listedReader += strlen(listedReader) + 1) {
+        printf("\t- %s\n", listedReader);
+    }
     // ensure you connected to ACR122U, this code is only tested with that reader
-    const char *substring = "ACR122";
-    BOOL isCorrectReader = containsSubstring(reader, substring);
-    if (!isCorrectReader) {
-        LOG_CRITICAL("Your reader does not seem to be an ACR122U, cancelling program execution!");
+    char acr122Readers[READER_POOL_MAX_READERS][256];
+    if (findAcr122Readers(hContext, acr122Readers, READER_POOL_MAX_READERS) == 0) {
+        LOG_CRITICAL("None of your readers seems to be an ACR122U, cancelling program execution!");
         disconnectReader(hCard, hContext);
         return 1;
     }
+    char *reader = acr122Readers[0];
+    LOG_INFO("Using reader %s", reader);
     printf("\n");
 
     // Turn off buzzer of ACR122U
@@ -455,33 +537,52 @@ int main(void) {
         
     }
 
+    // Wait for a tag: SCardGetStatusChange blocks inside pcsc until one is placed on the reader (no polling)
+    PresenceWatcher watcher;
+    lRet = presence_watcher_init(&watcher, hContext, reader);
+    if (lRet != SCARD_S_SUCCESS) {
+        SCardReleaseContext(hContext);
+        return 1;
+    }
+    if (!presence_card_present(&watcher)) {
+        LOG_WARN("Did not detect a connected tag / NFC chip, please hold one near the reader\n");
+    }
+
     // Connect to the first reader
-    lRet = connectToReader(hContext, reader, &hCard, &dwActiveProtocol, FALSE);
-    BOOL didPrintWarningAlready = FALSE;
-    while (lRet != SCARD_S_SUCCESS) {
-        if ((lRet == SCARD_E_NO_SMARTCARD) || (lRet == SCARD_W_REMOVED_CARD) || (lRet == SCARD_E_TIMEOUT) || (lRet == SCARD_E_NO_SMARTCARD)) {
-            if (!didPrintWarningAlready) {
-                LOG_WARN("Did not detect a connected tag / NFC chip, please hold one near the reader\n");
-                didPrintWarningAlready = TRUE;
-            }
-        }
-        else {
-            if (!didPrintWarningAlready) {
-                LOG_ERROR("Google this pcsc-lite error code: 0x%x\n", (unsigned int)lRet);
-                didPrintWarningAlready = TRUE;
+    do {
+        PresenceResult presence;
+        PresenceEvent event = presence_wait_for_card(&watcher, INFINITE, &presence);
+        if (event != PRESENCE_CARD_INSERTED) {
+            if (event == PRESENCE_READER_UNAVAILABLE) {
+                LOG_CRITICAL("Reader %s is not available anymore\n", reader);
+            } else {
+                LOG_ERROR("Google this pcsc-lite error code: 0x%x\n", (unsigned int)presence.status);
             }
+            SCardReleaseContext(hContext);
+            return 1;
         }
-        
-        // wait a bit and retry (maybe user is not holding a tag near the reader yet)
-        SLEEP_CUSTOM(50); // milliseconds (don't put this value too low, it never worked for me with 1 ms)
+
         lRet = connectToReader(hContext, reader, &hCard, &dwActiveProtocol, FALSE);
+    } while ((lRet == SCARD_E_NO_SMARTCARD) || (lRet == SCARD_W_REMOVED_CARD)); // tag was taken away again before we could connect, wait for the next one
+    if (lRet != SCARD_S_SUCCESS) {
+        LOG_ERROR("Google this pcsc-lite error code: 0x%x\n", (unsigned int)lRet);
+        SCardReleaseContext(hContext);
+        return 1;
     }
     LOG_INFO("Connected to reader %s and detected an NFC tag\n", reader);
 
+    // the session holds the handle, receive buffers and statistics, every driver function takes it
+    acr_session *session = acr_session_create(hCard);
+    if (session == NULL) {
+        LOG_CRITICAL("Failed to allocate session\n");
+        disconnectReader(hCard, hContext);
+        return 1;
+    }
+
     // -------------- Interact with tag ---------------------------
 
     // Get UID of detected tag
-    lRet = getUID(hCard, pbRecvBuffer, &pbRecvBufferSize, TRUE);
+    lRet = getUID(session, TRUE);
     if (lRet != SCARD_S_SUCCESS) {
         if (!(lRet == ACR_90_00_FAILURE)) {
             LOG_WARN("Failed to get UID of tag: 0x%x\n", (unsigned int)lRet);
@@ -489,24 +590,36 @@ int main(void) {
             LOG_WARN("Failed to get UID of tag: ACR122U did not return the expected 90 00 return code!\n");
         }
         
+        acr_session_destroy(session);
         disconnectReader(hCard, hContext);
         return 1;
     }
 
-    lRet = getStatus(&hCard, mszReaders, dwState, dwReaders, &dwActiveProtocol, pbRecvBufferLarge, &pbRecvBufferSizeLarge, TRUE, connectedTag);
+    lRet = getStatus(session, mszReaders, dwState, dwReaders, &dwActiveProtocol, TRUE, connectedTag);
     if (lRet != SCARD_S_SUCCESS) {
         LOG_WARN("Failed to get status of tag: 0x%x\n", (unsigned int)lRet);
+        acr_session_destroy(session);
         disconnectReader(hCard, hContext);
         return 1;
     }
     // printf("%s", connectedTag);
 
+    // getStatus can not tell the Type 2 tags apart, GET_VERSION can
+    if (strcmp(connectedTag, TYPE2_TAG_NAME_UNDETERMINED) == 0) {
+        const Type2TagModel *model = type2_detect(session);
+        if (model != NULL) {
+            printf("Identified tag as: %s\n", model->name);
+            strncpy(connectedTag, model->name, 99);
+        }
+    }
+
     // only try to get RATS if currently connected tag is DESFIRE 8k (only desfire i have) or NTAG 424 DNA TT
     //      strcmp only reads (and compares) up to the \n terminator, so it doesn't matter what is in rest of array
     if (strcmp(connectedTag, "Mifare Desfire EV3 8k or NTAG 424 DNA TT") == 0) {
-        ApduResponse response = getATS_14443A(hCard, pbRecvBuffer, &pbRecvBufferSize, connectedTag);
+        ApduResponse response = getATS_14443A(session, connectedTag);
         if (response.status != SCARD_S_SUCCESS) {
             LOG_WARN("Failed to get ATS of tag: 0x%x\n", (unsigned int)lRet);
+            acr_session_destroy(session);
             disconnectReader(hCard, hContext);
             return 1;
         }
@@ -515,55 +628,118 @@ int main(void) {
         //printf("%s", connectedTag);
     }
     
-    // ----------- Mifare Classic 1k Examples ------------------------
+    // ----------- Session mode EXAMPLE (many tags in a row) ------------------------
+    //  Instead of this one-shot program, keep the context and reader handle alive across tags:
+    //      static BOOL wipe_tag(ReaderSession *session, void *userData) {
+    //          return ntag_215_reset_user_data(session->acr);
+    //      }
+    //      ReaderSession session;
+    //      reader_session_open(&session, NULL); // NULL: first ACR122 that is connected
+    //      ReaderSessionHooks hooks = { .onTag = wipe_tag };
+    //      reader_session_run(&session, &hooks, NULL, 0); // 0: run until the reader fails
+    //      reader_session_close(&session);
+    //
+    //  With several ACR122U connected, run one worker per reader and hand out jobs (whichever reader gets a tag first takes the next one):
+    //      static BOOL wipe_job(acr_session *session, void *arg) {
+    //          return ntag_215_reset_user_data(session);
+    //      }
+    //      ReaderPool pool; // large, make it static
+    //      reader_pool_start(&pool);
+    //      for (uint32_t i = 0; i < 100; i++) {
+    //          Job job = { .run = wipe_job, .arg = NULL, .id = i };
+    //          reader_pool_submit(&pool, &job);
+    //      }
+    //      reader_pool_finish(&pool); // returns once all 100 tags were wiped
+
+    // ----------- Mifare Classic (Mini / 1k / 4k) Examples ------------------------
+    //  every function takes the geometry of the tag: MIFARE_CLASSIC_GEOMETRY_MINI, _1K or _4K, or look it up by the name that getStatus determined:
+    //      const MifareClassicGeometry *geometry = mifare_classic_geometry_of_tag(connectedTag); // NULL: not a Mifare Classic tag
 
     // READING EXAMPLES
-        // example 1:   mifare_classic_read_sector(0x02, KEY_A_DEFAULT, hCard, pbRecvBuffer, &pbRecvBufferSize);
+        // example 1:   mifare_classic_read_sector(geometry, 0x02, KEY_A_DEFAULT, session);
         //              -> read all blocks in sector 2, use KEY_A_DEFAULT (FF FF FF FF FF FF)
-        // example 2:   mifare_classic_read_sector(0x03, KEY_A_NDEF_SECTOR115, hCard, pbRecvBuffer, &pbRecvBufferSize);
-        //              -> read all blocks in sector 3, use KEY_A_NDEF_SECTOR115
-        // example 3:   mifare_classic_read_sector(0x00, KEY_A_NDEF_SECTOR0, hCard, pbRecvBuffer, &pbRecvBufferSize);
-        //              -> read all blocks in sector 0, use KEY_A_NDEF_SECTOR0
-    //SectorContent sector_content = mifare_classic_read_sector(0x00, KEY_A_NDEF_SECTOR0, hCard, pbRecvBuffer, &pbRecvBufferSize);
+        // example 2:   mifare_classic_read_sector(geometry, 0x03, KEY_A_NDEF_SECTOR, session);
+        //              -> read all blocks in sector 3, use KEY_A_NDEF_SECTOR
+        // example 3:   mifare_classic_read_sector(geometry, 0x00, KEY_A_NDEF_MAD_SECTOR, session);
+        //              -> read all blocks in sector 0, use KEY_A_NDEF_MAD_SECTOR
+    //SectorContent sector_content = mifare_classic_read_sector(geometry, 0x00, KEY_A_NDEF_MAD_SECTOR, session);
     
     // WRITING EXAMPLE
         // example 1:   write the array below to block 0x04
             // const BYTE BlockData[16] = { 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F };
-            // BOOL success = mifare_classic_write_block(BlockData, 0x04, KEY_A_NDEF_SECTOR115, hCard, pbRecvBuffer, &pbRecvBufferSize);
+            // BOOL success = mifare_classic_write_block(geometry, BlockData, 0x04, KEY_A_NDEF_SECTOR, session);
    
-        // example 2:   spam write data on your uninitialized mifare classik 1k
-            // for (BYTE i = 0x01; i < 0x3F + 1; i++) {
-            //     if(is_byte_in_array(i, SECTOR_BLOCKS, 16)) continue;
+        // example 2:   spam write data on your uninitialized mifare classic (good for testing the zero wipe functions)
+            // for (uint16_t i = 0x01; i < geometry->amountBlocks; i++) {
+            //     if (mifare_classic_is_trailer_block((BYTE)i)) continue; // skip trailer blocks
 
             //     BYTE BlockData[16];
             //     memset(BlockData, i, sizeof(BlockData)); // array is full of i (in block x write value x 16 times)
 
-            //     BOOL success = mifare_classic_write_block(BlockData, i, KEY_A_DEFAULT, hCard, pbRecvBuffer, &pbRecvBufferSize);
+            //     BOOL success = mifare_classic_write_block(geometry, BlockData, (BYTE)i, KEY_A_DEFAULT, session);
             //     if (!success) return 1;
             // }
 
     // CARD RESET EXAMPLE
     //  // example 1: tag is NDEF formatted:
-    //      mifare_classic_reset_card(KEY_A_NDEF_SECTOR115, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      mifare_classic_reset_card(geometry, KEY_A_NDEF_SECTOR, session);
     
     //  // example 2: tag is NDEF uninitialized but u want to reset all blocks to zero:
-    //      mifare_classic_reset_card(KEY_A_DEFAULT, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      mifare_classic_reset_card(geometry, KEY_A_DEFAULT, session);
 
     // NDEF TO UNINTITIALIZED EXAMPLE
-    //mifare_classic_ndef_to_uninitialized(hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //mifare_classic_ndef_to_uninitialized(geometry, session);
 
     // UNINTITIALIZED TO NDEF EXAMPLE
-    //      mifare_classic_uninitialized_to_ndef(hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      mifare_classic_uninitialized_to_ndef(geometry, session);
+
+    // NDEF READ EXAMPLE (reads only the sectors the MAD assigns to NDEF, and only as far as the message goes)
+    //      BYTE message[1024]; size_t messageLength;
+    //      if (mifare_classic_read_ndef(message, sizeof(message), &messageLength, session)) printHex(message, (DWORD)messageLength);
+
+    // NDEF WRITE EXAMPLE (NewNDEF_SR_Text returns the TLV: skip its 2 header bytes, mifare_classic_write_ndef adds TLV and terminator itself)
+    //      size_t textSize;
+    //      BYTE *text = NewNDEF_SR_Text((const BYTE *)"Hello, world!", 13, &textSize);
+    //      mifare_classic_write_ndef(text + 2, text[1], session);
+    //      free(text);
+
+    // KEY RESOLVER EXAMPLE (fleet of cards with different keys: tries the keysets per sector and remembers the keys of every UID)
+    //      static MifareClassicKeyResolver resolver; // large, make it static (one per reader)
+    //      mifare_classic_resolver_init(&resolver);
+    //      mifare_classic_resolver_add_keyset(&resolver, &MIFARE_CLASSIC_DEFAULT_KEYSET);
+    //      mifare_classic_resolver_add_keyset(&resolver, &myInHouseKeyset);
+    //      static MifareClassicImage image;
+    //      mifare_classic_dump_with(mifare_classic_resolver_source, &resolver, &image, NULL, NULL, session);
+    //  or for a single sector:
+    //      MifareClassicKey key;
+    //      if (mifare_classic_resolve_key(&resolver, 0x03, &key, session)) mifare_classic_read_sector_blocks(0x03, key.keyType, key.key, blocks, session);
+
+    // VALUE BLOCK EXAMPLE (stored-value token: balance in block 0x05, backup copy in block 0x06)
+    //      mifare_classic_store_value(geometry, 0x05, MIFARE_CLASSIC_KEY_A, KEY_A_DEFAULT, 1000, session);
+    //      int32_t balance;
+    //      mifare_classic_adjust_value(geometry, 0x05, MIFARE_CLASSIC_KEY_A, KEY_A_DEFAULT, -250, 0x06, &balance, session); // balance: 750
+
+    // ACCESS BITS EXAMPLE (custom sector trailer: data blocks read-only for key A and writable with key B, trailer managed by key B)
+    //      BYTE trailer[16], conditions[4] = { 0x04, 0x04, 0x04, 0x03 }; // C1 C2 C3 = 1 0 0 for the data blocks, 0 1 1 for the trailer
+    //      memcpy(trailer, myKeyA, 6); mifare_classic_access_bits_encode(conditions, trailer + 6); trailer[9] = 0x00; memcpy(trailer + 10, myKeyB, 6);
+    //      mifare_classic_write_sector(0x02, MIFARE_CLASSIC_KEY_A, KEY_A_DEFAULT, NULL, trailer, session); // refused if the trailer would lock the sector
+    //      BYTE keyType = mifare_classic_access_key_type(trailer + 6, 0x08, MIFARE_CLASSIC_ACCESS_WRITE, MIFARE_CLASSIC_KEY_A); // MIFARE_CLASSIC_KEY_B
+
+    // DUMP / RESTORE EXAMPLE
+    //      static MifareClassicImage image; // image.size = 0: size of the tag that is lying on the reader
+    //      mifare_classic_dump(&MIFARE_CLASSIC_DEFAULT_KEYSET, &image, NULL, NULL, session);
+    //      ... change image.data ..., then only the blocks that changed are written:
+    //      mifare_classic_write_image(NULL, &changed, &image, session);
 
     // ------------------------- NTAG-215 EXAMPLES ------------------------
     //  WRITE TO PAGE:
     //      BYTE Msg[4] = { 0x05, 0x04, 0x03, 0x04 };
-    //      BOOL success = ntag_215_write_page(Msg, 0x29, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      BOOL success = ntag_215_write_page(Msg, 0x29, session);
     //  RESET USER MEMORY TO ZEROES:
-    //      BOOL success = ntag_215_reset_user_data(hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      BOOL success = ntag_215_reset_user_data(session);
 
     //  READ FROM PAGE start TO PAGE end (here: read entire tag at once)
-    //BOOL success = ntag_215_fast_read(0x00, 0x86, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //BOOL success = ntag_215_fast_read(0x00, 0x86, session);
 
     // -------------------- NDEF SR Text creation EXAMPLE ----------------
     // const char* my_text = "hello world!";
@@ -587,81 +763,91 @@ int main(void) {
     //     printf("Block %2zu: %02X %02X %02X %02X\n", i, output[i][0], output[i][1], output[i][2], output[i][3]);
     // }
 
+    // -------------------- Type 2 EXAMPLES (Ultralight, Ultralight EV1, NTAG 210 - 216) ---------------
+    //  the model (page layout) of the tag on the reader, GET_VERSION is only sent once per tag:
+    //      const Type2TagModel *model = type2_detect(session);
+    //  READ FROM PAGE start TO PAGE end (here: read entire tag)
+    //      type2_fast_read(model, 0x00, model->amountPages - 1, session);
+    //  READ INTO YOUR OWN BUFFER instead of printing (here: user memory of the tag):
+    //      BYTE UserMemory[TYPE2_MAX_PAGES * TYPE2_PAGE_SIZE];
+    //      type2_read_pages(model, 0x04, model->lastUserPage, UserMemory, sizeof(UserMemory), session);
+    //  or get every exchange as soon as it arrives (e.g. to hash it), return FALSE from the callback to stop:
+    //      type2_read_pages_with(model, 0x04, model->lastUserPage, yourCallback, yourArg, session);
+    //  WRITE TO PAGE (user memory only):
+    //      BYTE Msg[4] = { 0x05, 0x04, 0x03, 0x04 };
+    //      type2_write_page(model, Msg, 0x05, session);
+    //  RESET USER MEMORY TO ZEROES:
+    //      type2_reset_user_data(model, session);
+    //  or only write the pages that are not zeroes yet (reads the user memory first, a blank tag costs a few reads instead of a write per page):
+    //      type2_reset_changed_user_data(model, session);
+    //  WRITE AN IMAGE OF PAGES 0x04 - 0x07, skipping the pages that already have that content:
+    //      BYTE Image[4 * TYPE2_PAGE_SIZE] = { 0x03, 0x0b, 0xd1, 0x01, 0x07, 0x54, 0x02, 0x65, 0x6e, 0x41, 0x43, 0x52, 0x31, 0x32, 0x32, 0xfe };
+    //      type2_write_changed_pages(model, Image, 0x04, 0x07, session);
+    //  WRITE A FULL TAG IMAGE (user memory, CFG0 / CFG1 / PWD / PACK, lock bytes) in one call, e.g. a modified copy of what type2_read_pages returned:
+    //      BYTE TagImage[TYPE2_MAX_PAGES * TYPE2_PAGE_SIZE];
+    //      type2_read_pages(model, 0x00, model->amountPages - 1, TagImage, sizeof(TagImage), session);
+    //      TagImage[model->configPage * TYPE2_PAGE_SIZE + 3] = 0x10;   // AUTH0: password protect everything from page 0x10 on
+    //      memcpy(TagImage + (model->configPage + 2) * TYPE2_PAGE_SIZE, (BYTE[]){ 0x12, 0x34, 0x56, 0x78 }, 4);   // PWD
+    //      type2_write_image(model, TagImage, NULL, session);
+    //  PASSWORD PROTECTION (NTAG 21x, Ultralight EV1): protect reads and writes from page 0x04 on with password 12 34 56 78 and PACK ab cd
+    //      BYTE Password[4] = { 0x12, 0x34, 0x56, 0x78 };
+    //      BYTE Pack[2] = { 0xab, 0xcd };
+    //      type2_set_protection(model, 0x04, TRUE, Password, Pack, session);
+    //  AUTHENTICATE (checks the PACK, only sent once while the tag stays on the reader, so call it before every operation of a batch):
+    //      type2_authenticate(model, Password, Pack, session);
+
     // -------------------- Mifare Ultralight EXAMPLES ---------------
     // READ PAGE (here: page 0x06)
-    //      ultralight_read_page(0x12, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ultralight_read_page(0x12, session);
     // FAST READ ENTIRE TAG
-    //      ultralight_fast_read(hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ultralight_fast_read(session);
     // WRITE TO PAGE
     //      BYTE Msg[4] = { 0x05, 0x04, 0x03, 0x04 };
-    //      ultralight_write_page(Msg, 0x05, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ultralight_write_page(Msg, 0x05, session);
     // RESET USER-MEMORY
-    //      ultralight_reset_user_data(hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ultralight_reset_user_data(session);
     // READ COUNTER
     //   Counter 0:
-    //      ultralight_read_counter(0x00, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ultralight_read_counter(0x00, session);
     //   Counter 1:
-    //      ultralight_read_counter(0x01, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ultralight_read_counter(0x01, session);
     //   Counter 2:
-    //      ultralight_read_counter(0x02, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ultralight_read_counter(0x02, session);
     // INCREMENT COUNTER BY 1 (i could also implement increment by x <= 16_777_215 at some point)
     //  Counter 0:
-    //      ultralight_increment_counter(0x00, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ultralight_increment_counter(0x00, session);
     //  Counter 1:
-    //      ultralight_increment_counter(0x01, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ultralight_increment_counter(0x01, session);
     //  Counter 2:
-    //      ultralight_increment_counter(0x02, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ultralight_increment_counter(0x02, session);
     
-    // ----------- Mifare Classic 4k Examples ------------------------
-    //  READ SECTOR
-    //      mifare_classic_4k_read_sector(0x01, KEY_A_DEFAULT_4K, hCard, pbRecvBuffer, &pbRecvBufferSize);
-    //  WRITE BLOCK
-    //      const BYTE BlockData[16] = { 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F };
-    //      mifare_classic_4k_write_block(BlockData, 0x04, KEY_A_DEFAULT_4K, hCard, pbRecvBuffer, &pbRecvBufferSize);
-    //  RESET CARD
-    //      Example 1: tag is NDEF formatted:
-    //          mifare_classic_4k_reset_card(KEY_A_NDEF_SECTOR_1_TO_0F_AND_11_TO_27_4K, hCard, pbRecvBuffer, &pbRecvBufferSize);
-    //      Example 2: tag is NDEF uninitialized but u want to reset all blocks to zero:
-    //          mifare_classic_4k_reset_card(KEY_A_DEFAULT, hCard, pbRecvBuffer, &pbRecvBufferSize);
-    //  SPAM UNINITIALIZED TAG WITH DATA (good for testing the zero wipe functions)
-    //      for (BYTE i = 0x01; i < 0xFF; i++) {
-    //          if(is_byte_in_array(i, SECTOR_TRAILER_BLOCKS_4K, 40)) continue; // skip trailer blocks
-
-    //          BYTE BlockData[16];
-    //          memset(BlockData, i, sizeof(BlockData)); // array is full of i (in block x write value x 16 times)
-
-    //          BOOL success = mifare_classic_4k_write_block(BlockData, i, KEY_A_DEFAULT, hCard, pbRecvBuffer, &pbRecvBufferSize);
-    //          if (!success) return 1;
-    //      }
-
-    //  UNINITIALIZED TO NDEF-FORMATTED:
-    //          mifare_classic_4k_uninitialized_to_ndef(hCard, pbRecvBuffer, &pbRecvBufferSize);
-    //  NDEF-FORMATTED TO UNINITIALIZED:
-    //          mifare_classic_4k_ndef_to_uninitialized(hCard, pbRecvBuffer, &pbRecvBufferSize);
-
     // ---------------------------- NTAG 213 EXAMPLES -------------------
     //  WRITE TO PAGE:
     //      BYTE Msg[4] = { 0x05, 0x04, 0x03, 0x04 };
-    //      ntag_213_write_page(Msg, 0x14, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ntag_213_write_page(Msg, 0x14, session);
     //  RESET USER MEMORY TO ZEROES:
-    //      ntag_213_reset_user_data(hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ntag_213_reset_user_data(session);
     //  READ FROM PAGE start TO PAGE end (here: read entire tag at once)
-    //      ntag_213_fast_read(0x00, 0x2C, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ntag_213_fast_read(0x00, 0x2C, session);
 
     // ---------------------------- NTAG 216 EXAMPLES -------------------
     //  WRITE TO PAGE:
     //      BYTE Msg[4] = { 0x05, 0x04, 0x03, 0x04 };
-    //      ntag_216_write_page(Msg, 0x14, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ntag_216_write_page(Msg, 0x14, session);
     //  RESET USER MEMORY TO ZEROES:
-    //      ntag_216_reset_user_data(hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ntag_216_reset_user_data(session);
     //  READ FROM PAGE start TO PAGE end (here: read entire tag at once)
-    //      ntag_216_fast_read(0x00, 0xE6, hCard, pbRecvBuffer, &pbRecvBufferSize);
+    //      ntag_216_fast_read(0x00, 0xE6, session);
 
     // ------------------------------------------------------------------
 
-    // TODO: why can't getStatus() distinguish between Ultralight and NTAG? and then also be able to distinguish ntag 2xx variants
+    // print every APDU that was exchanged with the tag and how long each kind of APDU / operation took
+    apdu_trace_dump(acr_session_trace(session));
+    metrics_dump();
 
     // Clean up
+    acr_session_destroy(session);
     disconnectReader(hCard, hContext);
     return 0;
 }
+#endif // ACR122U_NO_MAIN
@@ -5,26 +5,38 @@
 #include "common.h"
 #endif
 
+#ifndef ACR_SESSION_H
+#include "acr-session.h"
+#endif
+
 // ApduResponse is a struct that holds both the status (e.g. success or failure) and the amount of bytes that the response consists of (e.g. 16)
 typedef struct {
     LONG status;
     LONG amount_response_bytes;
 } ApduResponse;
 
+// InCommunicateThru (ff 00 00 00 Lc d4 42 ..) is answered with d5 43 <status> .. 90 00: an error of the tag only shows in <status>
+#define PN532_STATUS_OK 0x00
+#define PN532_STATUS_TIMEOUT 0x01   // the tag did not answer (in time), which is also how the NAK of a Type 2 tag is reported
+
 // general functions
 LONG getAvailableReaders(SCARDCONTEXT hContext, char *mszReaders, DWORD *dwReaders);
+DWORD findAcr122Readers(SCARDCONTEXT hContext, char readers[][256], DWORD maxReaders);
 LONG connectToReader(SCARDCONTEXT hContext, const char *reader, SCARDHANDLE *hCard, DWORD *dwActiveProtocol, BOOL directConnect);
-ApduResponse executeApdu(SCARDHANDLE hCard, BYTE *pbSendBuffer, DWORD dwSendLength, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
+ApduResponse executeApdu(acr_session *session, BYTE *pbSendBuffer, DWORD dwSendLength);
 LONG disableBuzzer(SCARDCONTEXT hContext, const char *reader, SCARDHANDLE *hCard, DWORD *dwActiveProtocol, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
 void disconnectReader(SCARDHANDLE hCard, SCARDCONTEXT hContext);
 
 // general interactions with tags
-LONG getUID(SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize, BOOL printResult);
-ApduResponse getATS_14443A(SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize, char *tagName);
-LONG getStatus(SCARDHANDLE *hCard, char *mszReaders, DWORD dwState, DWORD dwReaders, DWORD *dwActiveProtocol, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize, BOOL printResult, char *tagName);
+LONG getUID(acr_session *session, BOOL printResult);
+ApduResponse getATS_14443A(acr_session *session, char *tagName);
+LONG getStatus(acr_session *session, char *mszReaders, DWORD dwState, DWORD dwReaders, DWORD *dwActiveProtocol, BOOL printResult, char *tagName);
+BOOL reselectTag(acr_session *session);
 
 // helper functions
 BOOL containsSubstring(const char *string, const char *substring);
+BOOL isSuccessResponse(ApduResponse response, const BYTE *pbRecvBuffer, LONG dataLength);
+BOOL isTagSuccessResponse(ApduResponse response, const BYTE *pbRecvBuffer, LONG dataLength);
 void printHex(LPCBYTE pbData, DWORD cbData);
 void dump_response_buffer(BYTE *pbRecvBuffer);
 void dump_response_buffer_256(BYTE *pbRecvBuffer);
@@ -0,0 +1,225 @@
+#include "metrics.h"
+
+typedef struct MetricsOperation {
+    const char *name;               // NULL: free slot (claimed with a compare-and-swap)
+    MetricsHistogram histogram;
+} MetricsOperation;
+
+static BOOL metricsEnabled = FALSE;
+static MetricsHistogram apduHistograms[APDU_CLASS_COUNT];
+static MetricsOperation operations[METRICS_MAX_OPERATIONS];
+
+static const char *APDU_CLASS_NAMES[APDU_CLASS_COUNT] = {
+    [APDU_CLASS_LOAD_KEY] = "load key",
+    [APDU_CLASS_AUTHENTICATE] = "authenticate",
+    [APDU_CLASS_READ_BINARY] = "read binary",
+    [APDU_CLASS_UPDATE_BINARY] = "update binary",
+    [APDU_CLASS_VALUE_BLOCK] = "value block",
+    [APDU_CLASS_GET_DATA] = "get data",
+    [APDU_CLASS_THRU_READ] = "thru READ",
+    [APDU_CLASS_THRU_FAST_READ] = "thru FAST_READ",
+    [APDU_CLASS_THRU_WRITE] = "thru WRITE",
+    [APDU_CLASS_THRU_OTHER] = "thru other",
+    [APDU_CLASS_ESCAPE] = "escape",
+    [APDU_CLASS_OTHER] = "other",
+};
+
+// metrics_enable turns recording on or off (off by default)
+void metrics_enable(BOOL enabled) {
+    __atomic_store_n(&metricsEnabled, enabled, __ATOMIC_RELAXED);
+}
+
+BOOL metrics_enabled(void) {
+    return __atomic_load_n(&metricsEnabled, __ATOMIC_RELAXED);
+}
+
+// metrics_reset clears all histograms (operation names stay registered), not meant to be called while APDUs are being recorded
+void metrics_reset(void) {
+    memset(apduHistograms, 0, sizeof(apduHistograms));
+    for (int i = 0; i < METRICS_MAX_OPERATIONS; i++) {
+        memset(&operations[i].histogram, 0, sizeof(operations[i].histogram));
+    }
+}
+
+// -------------------- Classification -------------------------------
+
+// metrics_classify_apdu tells which kind of ACR122U pseudo-APDU is sent (API-ACR122U-2.04)
+ApduClass metrics_classify_apdu(const BYTE *pbSendBuffer, DWORD dwSendLength) {
+    if ((dwSendLength < 2) || (pbSendBuffer[0] != 0xFF)) {
+        return APDU_CLASS_OTHER;
+    }
+
+    switch (pbSendBuffer[1]) {
+        case 0x82: return APDU_CLASS_LOAD_KEY;
+        case 0x86:
+        case 0x88: return APDU_CLASS_AUTHENTICATE;
+        case 0xB0: return APDU_CLASS_READ_BINARY;
+        case 0xD6: return APDU_CLASS_UPDATE_BINARY;
+        case 0xB1:
+        case 0xD7: return APDU_CLASS_VALUE_BLOCK;
+        case 0xCA: return APDU_CLASS_GET_DATA;
+        case 0x00: break;
+        default:   return APDU_CLASS_OTHER;
+    }
+
+    // FF 00 00 00 Lc D4 42 <tag command> ..
+    if ((dwSendLength < 8) || (pbSendBuffer[5] != 0xD4) || (pbSendBuffer[6] != 0x42)) {
+        return APDU_CLASS_OTHER;
+    }
+    switch (pbSendBuffer[7]) {
+        case 0x30: return APDU_CLASS_THRU_READ;
+        case 0x3A: return APDU_CLASS_THRU_FAST_READ;
+        case 0xA2: return APDU_CLASS_THRU_WRITE;
+        default:   return APDU_CLASS_THRU_OTHER;
+    }
+}
+
+const char *metrics_apdu_class_name(ApduClass apduClass) {
+    return (apduClass < APDU_CLASS_COUNT) ? APDU_CLASS_NAMES[apduClass] : "?";
+}
+
+// -------------------- Histograms -------------------------------
+
+// values 0 - 3 get a bucket each, above that every power of two is split into 4 buckets
+static int metrics_bucket_of(uint64_t value) {
+    if (value < 4) {
+        return (int)value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int bucket = 4 + (msb - 2) * 4 + (int)((value >> (msb - 2)) & 3);
+    return (bucket < METRICS_BUCKETS) ? bucket : METRICS_BUCKETS - 1;
+}
+
+// smallest value that falls into bucket
+static uint64_t metrics_bucket_start(int bucket) {
+    if (bucket < 4) {
+        return (uint64_t)bucket;
+    }
+    int msb = (bucket - 4) / 4 + 2;
+    return (uint64_t)(4 + (bucket - 4) % 4) << (msb - 2);
+}
+
+static void metrics_histogram_add(MetricsHistogram *histogram, uint64_t value) {
+    __atomic_fetch_add(&histogram->buckets[metrics_bucket_of(value)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->sum_us, value, __ATOMIC_RELAXED);
+
+    uint64_t max = __atomic_load_n(&histogram->max_us, __ATOMIC_RELAXED);
+    while ((value > max) && !__atomic_compare_exchange_n(&histogram->max_us, &max, value, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        // max was updated with the current value, try again
+    }
+}
+
+// percentile is reported as the last value of the bucket it falls into (capped at the actual maximum)
+static uint64_t metrics_histogram_percentile(const MetricsHistogram *histogram, uint64_t count, uint64_t max, int percent) {
+    uint64_t rank = (count * (uint64_t)percent + 99) / 100; // 1-based rank of the sample
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < METRICS_BUCKETS; bucket++) {
+        seen += __atomic_load_n(&histogram->buckets[bucket], __ATOMIC_RELAXED);
+        if (seen >= rank) {
+            uint64_t end = (bucket + 1 < METRICS_BUCKETS) ? metrics_bucket_start(bucket + 1) - 1 : max;
+            return (end < max) ? end : max;
+        }
+    }
+    return max;
+}
+
+static BOOL metrics_histogram_summary(const MetricsHistogram *histogram, MetricsSummary *summary) {
+    memset(summary, 0, sizeof(*summary));
+    summary->count = __atomic_load_n(&histogram->count, __ATOMIC_RELAXED);
+    if (summary->count == 0) {
+        return FALSE;
+    }
+    summary->max_us = __atomic_load_n(&histogram->max_us, __ATOMIC_RELAXED);
+    summary->mean_us = __atomic_load_n(&histogram->sum_us, __ATOMIC_RELAXED) / summary->count;
+    summary->p50_us = metrics_histogram_percentile(histogram, summary->count, summary->max_us, 50);
+    summary->p99_us = metrics_histogram_percentile(histogram, summary->count, summary->max_us, 99);
+    return TRUE;
+}
+
+// -------------------- Recording -------------------------------
+
+void metrics_record_apdu(ApduClass apduClass, uint64_t duration_us) {
+    if (apduClass < APDU_CLASS_COUNT) {
+        metrics_histogram_add(&apduHistograms[apduClass], duration_us);
+    }
+}
+
+// metrics_find_operation returns the slot of name, registering it if create is set (NULL if unknown / the table is full)
+static MetricsOperation *metrics_find_operation(const char *name, BOOL create) {
+    for (int i = 0; i < METRICS_MAX_OPERATIONS; i++) {
+        const char *slotName = __atomic_load_n(&operations[i].name, __ATOMIC_ACQUIRE);
+        if (slotName == NULL) {
+            if (!create) {
+                return NULL;
+            }
+            if (__atomic_compare_exchange_n(&operations[i].name, &slotName, name, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                return &operations[i];
+            }
+            // another thread claimed this slot in the meantime, slotName now holds its name
+        }
+        if ((slotName == name) || (strcmp(slotName, name) == 0)) {
+            return &operations[i];
+        }
+    }
+    return NULL;
+}
+
+// metrics_record_operation adds the duration of one driver operation, name must stay valid forever (e.g. __func__ or a string literal)
+void metrics_record_operation(const char *name, uint64_t duration_us) {
+    MetricsOperation *operation = metrics_find_operation(name, TRUE);
+    if (operation != NULL) {
+        metrics_histogram_add(&operation->histogram, duration_us);
+    }
+}
+
+// -------------------- Reporting -------------------------------
+
+// metrics_apdu_summary fills summary with count / mean / p50 / p99 / max of one APDU class, returns FALSE if nothing was recorded
+BOOL metrics_apdu_summary(ApduClass apduClass, MetricsSummary *summary) {
+    if (apduClass >= APDU_CLASS_COUNT) {
+        memset(summary, 0, sizeof(*summary));
+        return FALSE;
+    }
+    return metrics_histogram_summary(&apduHistograms[apduClass], summary);
+}
+
+BOOL metrics_operation_summary(const char *name, MetricsSummary *summary) {
+    MetricsOperation *operation = metrics_find_operation(name, FALSE);
+    if (operation == NULL) {
+        memset(summary, 0, sizeof(*summary));
+        return FALSE;
+    }
+    return metrics_histogram_summary(&operation->histogram, summary);
+}
+
+static void metrics_print_summary(const char *name, const MetricsSummary *summary) {
+    printf("  %-42s %8llu %10llu %10llu %10llu %10llu\n", name, (unsigned long long)summary->count, (unsigned long long)summary->mean_us,
+        (unsigned long long)summary->p50_us, (unsigned long long)summary->p99_us, (unsigned long long)summary->max_us);
+}
+
+// metrics_dump prints every APDU class and operation that has been recorded at least once
+void metrics_dump(void) {
+    MetricsSummary summary;
+
+    printf("\nAPDU latency (us):\n");
+    printf("  %-42s %8s %10s %10s %10s %10s\n", "class", "count", "mean", "p50", "p99", "max");
+    for (int i = 0; i < APDU_CLASS_COUNT; i++) {
+        if (metrics_apdu_summary((ApduClass)i, &summary)) {
+            metrics_print_summary(APDU_CLASS_NAMES[i], &summary);
+        }
+    }
+
+    printf("\nOperation duration (us):\n");
+    printf("  %-42s %8s %10s %10s %10s %10s\n", "operation", "count", "mean", "p50", "p99", "max");
+    for (int i = 0; i < METRICS_MAX_OPERATIONS; i++) {
+        const char *name = __atomic_load_n(&operations[i].name, __ATOMIC_ACQUIRE);
+        if (name == NULL) {
+            break;
+        }
+        if (metrics_histogram_summary(&operations[i].histogram, &summary)) {
+            metrics_print_summary(name, &summary);
+        }
+    }
+    printf("\n");
+}
@@ -0,0 +1,60 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#ifndef COMMON_H
+#include "common.h"
+#endif
+
+// Latency instrumentation: executeApdu sorts every exchange into an ApduClass and records its wall-clock duration, every driver
+// operation (see acr_session_begin_operation) records its total duration under its function name. Both end up in fixed-bucket
+// histograms (4 buckets per power of two, so percentiles are exact to within 25%) that are updated with atomic adds and can be
+// read while readers are running. Recording is off by default, then the only cost is one branch per APDU.
+
+#define METRICS_BUCKETS 128         // covers 0 us .. 2^33 us (~2.4 hours), longer durations land in the last bucket (which starts at 7 * 2^30 us)
+#define METRICS_MAX_OPERATIONS 32   // distinct operation names
+
+typedef enum ApduClass {
+    APDU_CLASS_LOAD_KEY,            // FF 82
+    APDU_CLASS_AUTHENTICATE,        // FF 86 / FF 88
+    APDU_CLASS_READ_BINARY,         // FF B0
+    APDU_CLASS_UPDATE_BINARY,       // FF D6
+    APDU_CLASS_VALUE_BLOCK,         // FF B1 / FF D7 (read value block, value block operation / restore)
+    APDU_CLASS_GET_DATA,            // FF CA (UID / ATS)
+    APDU_CLASS_THRU_READ,           // InCommunicateThru READ (30)
+    APDU_CLASS_THRU_FAST_READ,      // InCommunicateThru FAST_READ (3A)
+    APDU_CLASS_THRU_WRITE,          // InCommunicateThru WRITE (A2)
+    APDU_CLASS_THRU_OTHER,          // InCommunicateThru anything else (READ_CNT, INCR_CNT, GET_VERSION, ..)
+    APDU_CLASS_ESCAPE,              // SCardControl escape commands (e.g. buzzer)
+    APDU_CLASS_OTHER,
+    APDU_CLASS_COUNT
+} ApduClass;
+
+typedef struct MetricsHistogram {
+    uint64_t buckets[METRICS_BUCKETS];
+    uint64_t count;
+    uint64_t sum_us;
+    uint64_t max_us;
+} MetricsHistogram;
+
+typedef struct MetricsSummary {
+    uint64_t count;
+    uint64_t mean_us;
+    uint64_t p50_us;
+    uint64_t p99_us;
+    uint64_t max_us;
+} MetricsSummary;
+
+void metrics_enable(BOOL enabled);
+BOOL metrics_enabled(void);
+void metrics_reset(void);
+
+ApduClass metrics_classify_apdu(const BYTE *pbSendBuffer, DWORD dwSendLength);
+const char *metrics_apdu_class_name(ApduClass apduClass);
+void metrics_record_apdu(ApduClass apduClass, uint64_t duration_us);
+void metrics_record_operation(const char *name, uint64_t duration_us);
+
+BOOL metrics_apdu_summary(ApduClass apduClass, MetricsSummary *summary);
+BOOL metrics_operation_summary(const char *name, MetricsSummary *summary);
+void metrics_dump(void);
+
+#endif
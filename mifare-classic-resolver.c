@@ -0,0 +1,154 @@
+#include "mifare-classic-resolver.h"
+#include "logging.c"
+#include "main.h"
+
+// mifare_classic_resolver_init gives an empty resolver, add the candidate keys with mifare_classic_resolver_add_keyset
+void mifare_classic_resolver_init(MifareClassicKeyResolver *resolver) {
+    memset(resolver, 0, sizeof(*resolver));
+    resolver->lastIndex = MIFARE_CLASSIC_RESOLVER_UNKNOWN;
+}
+
+// mifare_classic_resolver_add_keyset appends the keys of keyset (in their order, behind the keys that are already there, duplicates are skipped).
+// returns FALSE if not all of them fit (MIFARE_CLASSIC_RESOLVER_MAX_KEYS)
+BOOL mifare_classic_resolver_add_keyset(MifareClassicKeyResolver *resolver, const MifareClassicKeyset *keyset) {
+    for (size_t k = 0; k < keyset->amountKeys; k++) {
+        const MifareClassicKey *key = &keyset->keys[k];
+
+        BOOL known = FALSE;
+        for (BYTE i = 0; i < resolver->amountKeys; i++) {
+            if ((resolver->keys[i].keyType == key->keyType) && (memcmp(resolver->keys[i].key, key->key, 6) == 0)) {
+                known = TRUE;
+                break;
+            }
+        }
+        if (known) {
+            continue;
+        }
+
+        if (resolver->amountKeys >= MIFARE_CLASSIC_RESOLVER_MAX_KEYS) {
+            LOG_WARN("The key resolver is full (%d keys), the remaining keys of the keyset are ignored.", MIFARE_CLASSIC_RESOLVER_MAX_KEYS);
+            return FALSE;
+        }
+        resolver->keys[resolver->amountKeys] = *key;
+        resolver->hits[resolver->amountKeys] = 0;
+        resolver->order[resolver->amountKeys] = resolver->amountKeys;
+        resolver->amountKeys++;
+    }
+
+    return TRUE;
+}
+
+// mifare_classic_resolver_forget_cards empties the per-UID cache (the keys and their hit counts stay)
+void mifare_classic_resolver_forget_cards(MifareClassicKeyResolver *resolver) {
+    memset(resolver->cards, 0, sizeof(resolver->cards));
+}
+
+// mifare_classic_resolver_card returns the cache entry of the tag on the reader (a new one if the UID was not seen before),
+// NULL if the UID can not be determined (then nothing is cached)
+static MifareClassicResolvedCard *mifare_classic_resolver_card(MifareClassicKeyResolver *resolver, acr_session *session) {
+    BYTE uid[ACR_SESSION_MAX_UID];
+    BYTE uidLength = acr_session_uid(session, uid);
+    if (uidLength == 0) {
+        getUID(session, FALSE); // caches the UID in the session until the tag changes
+        uidLength = acr_session_uid(session, uid);
+        if (uidLength == 0) {
+            return NULL;
+        }
+    }
+
+    MifareClassicResolvedCard *victim = &resolver->cards[0];
+    for (int i = 0; i < MIFARE_CLASSIC_RESOLVER_CACHED_CARDS; i++) {
+        MifareClassicResolvedCard *card = &resolver->cards[i];
+        if ((card->uidLength == uidLength) && (memcmp(card->uid, uid, uidLength) == 0)) {
+            card->lastUsed = ++resolver->clock;
+            return card;
+        }
+        if ((victim->uidLength != 0) && ((card->uidLength == 0) || (card->lastUsed < victim->lastUsed))) {
+            victim = card; // unused entry, or the least recently used one
+        }
+    }
+
+    memcpy(victim->uid, uid, uidLength);
+    victim->uidLength = uidLength;
+    victim->lastUsed = ++resolver->clock;
+    memset(victim->keyIndex, MIFARE_CLASSIC_RESOLVER_UNKNOWN, sizeof(victim->keyIndex));
+    return victim;
+}
+
+static BOOL mifare_classic_resolver_try(const MifareClassicKeyResolver *resolver, BYTE index, BYTE sector, acr_session *session) {
+    const MifareClassicKey *key = &resolver->keys[index];
+    return mifare_classic_try_key(mifare_classic_sector_first_block(sector), sector, key->keyType, key->key, session);
+}
+
+// mifare_classic_resolver_hit remembers that key index opened sector: it moves up in the trial order and is tried first on the next sector
+static void mifare_classic_resolver_hit(MifareClassicKeyResolver *resolver, BYTE index, MifareClassicResolvedCard *card, BYTE sector, MifareClassicKey *key) {
+    resolver->hits[index]++;
+    BYTE position = 0;
+    while (resolver->order[position] != index) {
+        position++;
+    }
+    while ((position > 0) && (resolver->hits[resolver->order[position - 1]] < resolver->hits[index])) {
+        resolver->order[position] = resolver->order[position - 1];
+        resolver->order[--position] = index;
+    }
+
+    resolver->lastIndex = index;
+    if (card != NULL) {
+        card->keyIndex[sector] = index;
+    }
+    resolver->stats.resolved++;
+    *key = resolver->keys[index];
+}
+
+// mifare_classic_resolve_key authenticates sector and tells which key worked. the session keeps the sector authenticated,
+// so passing key on to e.g. mifare_classic_read_sector_blocks does not authenticate a second time
+BOOL mifare_classic_resolve_key(MifareClassicKeyResolver *resolver, BYTE sector, MifareClassicKey *key, acr_session *session) {
+    BOOL tried[MIFARE_CLASSIC_RESOLVER_MAX_KEYS] = {0};
+    MifareClassicResolvedCard *card = mifare_classic_resolver_card(resolver, session);
+
+    // repeat tap: the key of this card is known already
+    if ((card != NULL) && (card->keyIndex[sector] < resolver->amountKeys)) {
+        BYTE index = card->keyIndex[sector];
+        if (mifare_classic_resolver_try(resolver, index, sector, session)) {
+            resolver->stats.cacheHits++;
+            mifare_classic_resolver_hit(resolver, index, card, sector, key);
+            return TRUE;
+        }
+        LOG_INFO("The cached key of sector 0x%02x does not work anymore (card was re-keyed?), trying all keys..", sector);
+        card->keyIndex[sector] = MIFARE_CLASSIC_RESOLVER_UNKNOWN;
+        tried[index] = TRUE;
+    }
+
+    // the key of the previous sector first, it is still loaded in a key slot
+    if ((resolver->lastIndex < resolver->amountKeys) && !tried[resolver->lastIndex]) {
+        BYTE index = resolver->lastIndex;
+        tried[index] = TRUE;
+        resolver->stats.trials++;
+        if (mifare_classic_resolver_try(resolver, index, sector, session)) {
+            mifare_classic_resolver_hit(resolver, index, card, sector, key);
+            return TRUE;
+        }
+    }
+
+    for (BYTE i = 0; i < resolver->amountKeys; i++) {
+        BYTE index = resolver->order[i];
+        if (tried[index]) {
+            continue;
+        }
+        tried[index] = TRUE;
+        resolver->stats.trials++;
+        if (mifare_classic_resolver_try(resolver, index, sector, session)) {
+            mifare_classic_resolver_hit(resolver, index, card, sector, key);
+            return TRUE;
+        }
+    }
+
+    resolver->stats.failures++;
+    LOG_WARN("None of the %u keys of the resolver can authenticate sector 0x%02x", (unsigned int)resolver->amountKeys, sector);
+    return FALSE;
+}
+
+// mifare_classic_resolver_source is the MifareClassicKeySource of a resolver (ctx: MifareClassicKeyResolver), e.g. for mifare_classic_dump_with
+BOOL mifare_classic_resolver_source(void *ctx, BYTE sector, MifareClassicKey *key, acr_session *session) {
+    return mifare_classic_resolve_key((MifareClassicKeyResolver *)ctx, sector, key, session);
+}
@@ -0,0 +1,58 @@
+#ifndef MIFARE_CLASSIC_RESOLVER_H
+#define MIFARE_CLASSIC_RESOLVER_H
+
+#ifndef MAIN_H
+#include "main.h"
+#endif
+
+#ifndef COMMON_H
+#include "common.h"
+#endif
+
+#ifndef MIFARE_CLASSIC_H
+#include "mifare-classic.h"
+#endif
+
+// A MifareClassicKeyResolver finds the key of a sector when cards were provisioned with different keys (default keys, NDEF keys, in-house keysets).
+// Candidates are tried in the order of how often they worked so far, the key that opened the previous sector is tried first (it still sits in a
+// key slot of the reader, so trying it costs no load key APDU). Resolved keys are remembered per UID: repeat taps of the same card authenticate
+// every sector with the right key straight away, without a single trial authentication.
+// A resolver is not thread-safe, use one per reader (e.g. per ReaderWorker).
+
+#define MIFARE_CLASSIC_RESOLVER_MAX_KEYS 32
+#define MIFARE_CLASSIC_RESOLVER_CACHED_CARDS 64     // least recently used card is replaced
+#define MIFARE_CLASSIC_RESOLVER_UNKNOWN 0xFF        // keyIndex of a sector that was not resolved yet
+
+typedef struct MifareClassicResolvedCard {
+    BYTE uid[ACR_SESSION_MAX_UID];
+    BYTE uidLength;                                 // 0: unused entry
+    uint64_t lastUsed;
+    BYTE keyIndex[MIFARE_CLASSIC_MAX_SECTORS];      // index into MifareClassicKeyResolver.keys
+} MifareClassicResolvedCard;
+
+typedef struct MifareClassicResolverStats {
+    uint64_t resolved;          // sectors resolved
+    uint64_t cacheHits;         // sectors whose key was known from an earlier tap
+    uint64_t trials;            // authentications with a key that was not known to be right
+    uint64_t failures;          // sectors that none of the keys could authenticate
+} MifareClassicResolverStats;
+
+typedef struct MifareClassicKeyResolver {
+    MifareClassicKey keys[MIFARE_CLASSIC_RESOLVER_MAX_KEYS];
+    uint32_t hits[MIFARE_CLASSIC_RESOLVER_MAX_KEYS];
+    BYTE order[MIFARE_CLASSIC_RESOLVER_MAX_KEYS];   // trial order, most successful key first
+    BYTE amountKeys;
+    BYTE lastIndex;                                 // key that resolved the previous sector
+    MifareClassicResolvedCard cards[MIFARE_CLASSIC_RESOLVER_CACHED_CARDS];
+    uint64_t clock;
+    MifareClassicResolverStats stats;
+} MifareClassicKeyResolver;
+
+void mifare_classic_resolver_init(MifareClassicKeyResolver *resolver);
+BOOL mifare_classic_resolver_add_keyset(MifareClassicKeyResolver *resolver, const MifareClassicKeyset *keyset);
+void mifare_classic_resolver_forget_cards(MifareClassicKeyResolver *resolver);
+
+BOOL mifare_classic_resolve_key(MifareClassicKeyResolver *resolver, BYTE sector, MifareClassicKey *key, acr_session *session);
+BOOL mifare_classic_resolver_source(void *ctx, BYTE sector, MifareClassicKey *key, acr_session *session);
+
+#endif
@@ -0,0 +1,1183 @@
+#include "mifare-classic.h"
+#include "logging.c"
+#include "main.h"
+#include "ndef.h"
+
+// GEOMETRIES (sector 0x10 is the second MAD sector of an NDEF formatted 4k tag)
+const MifareClassicGeometry MIFARE_CLASSIC_GEOMETRY_MINI = { "Mifare Mini",			5,  20,  MIFARE_CLASSIC_MINI_SIZE };
+const MifareClassicGeometry MIFARE_CLASSIC_GEOMETRY_1K 	 = { "Mifare Classic 1k",	16, 64,  MIFARE_CLASSIC_1K_SIZE };
+const MifareClassicGeometry MIFARE_CLASSIC_GEOMETRY_4K 	 = { "Mifare Classic 4k",	40, 256, MIFARE_CLASSIC_4K_SIZE };
+
+static const MifareClassicGeometry *MIFARE_CLASSIC_GEOMETRIES[] = { &MIFARE_CLASSIC_GEOMETRY_MINI, &MIFARE_CLASSIC_GEOMETRY_1K, &MIFARE_CLASSIC_GEOMETRY_4K };
+
+// SECTOR TRAILERS
+//		NDEF FORMATTED
+const BYTE NDEF_MAD_SECTOR_TRAILER[16] =	  { 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5,   	// key A (sector 0x00, and 0x10 on 4k tags)
+												0x78, 0x77, 0x88, 0xC1,    				// access bits
+												0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };	// key B
+
+const BYTE NDEF_SECTOR_TRAILER[16] = 		  { 0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7,     // key A (every other sector)
+												0x7F, 0x07, 0x88, 0x40,     			// access bits
+												0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };	// key B
+
+//		UNINITIALIZED
+const BYTE UNINITIALIZED_SECTOR_TRAILER[16] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,  	// key A
+												0xFF, 0x07, 0x80, 0x69, 				// access bits
+												0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };	// key B
+
+// KEYS
+//		uninitialized default keys
+const BYTE KEY_A_DEFAULT[6] 			= { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+const BYTE KEY_B_DEFAULT[6] 			= { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+//		ndef-formatted default keys
+const BYTE KEY_A_NDEF_MAD_SECTOR[6] 	= { 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 };
+const BYTE KEY_B_NDEF_MAD_SECTOR[6] 	= { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+const BYTE KEY_A_NDEF_SECTOR[6] 		= { 0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7 };	// 64 33 66 37 64 33 66 37 64 33 66 37
+const BYTE KEY_B_NDEF_SECTOR[6] 		= { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+// ACCESS BITS
+const BYTE ACCESS_BITS_UNINITIALIZED[4] 	= { 0xFF, 0x07, 0x80, 0x69 };
+const BYTE ACCESS_BITS_NDEF_MAD_SECTOR[4] 	= { 0x78, 0x77, 0x88, 0xC1 };
+const BYTE ACCESS_BITS_NDEF_SECTOR[4] 		= { 0x7F, 0x07, 0x88, 0x40 };
+
+// NDEF Block 0x04 (first block of sector 1): empty NDEF message TLV followed by the terminator TLV
+const BYTE NDEF_EMPTY_MESSAGE_BLOCK[16] = { 0x03, 0x00, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+
+// mifare_classic_authenticate makes sure that the tag is authenticated for sector (the sector holding block) with key (keyType: MIFARE_CLASSIC_KEY_A / _KEY_B)
+// within one operation (see acr_session_begin_operation) the session remembers which keys sit in the reader's key slots and which sector is authenticated,
+// so load key (FF 82) and authenticate (FF 86) are only sent when that changes: writing the 3 data blocks of a sector in one operation costs one authentication, not three.
+// every outermost operation starts with an empty cache, so separate calls (e.g. three mifare_classic_write_block without an operation around them) authenticate each time.
+// any failed APDU or tag change makes the session forget the authentication (see executeApdu). with ACR_TRANSACTION_NONE nothing is remembered at all
+BOOL mifare_classic_authenticate(BYTE block, int sector, BYTE keyType, const BYTE *key, acr_session *session) {
+	BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
+	acr_session_enter_sector(session, sector);
+	if (acr_session_is_authenticated(session, sector, keyType, key)) {
+		LOG_DEBUG("Sector 0x%02x is already authenticated, no need to authenticate block 0x%02x", sector, block);
+		return TRUE;
+	}
+
+	// key A goes to slot 0 and key B to slot 1 (unless the key already is in a slot), so alternating between both keys never reloads them
+	int slot = acr_session_key_slot_of(session, key);
+	if (slot < 0) {
+		slot = (keyType == MIFARE_CLASSIC_KEY_B) ? 0x01 : 0x00;
+		LOG_INFO("Loading key into slot 0x%02x..", slot);
+		BYTE APDU_LoadKey[11] = { 0xff, 0x82, 0x00, (BYTE)slot, 0x06, key[0], key[1], key[2], key[3], key[4], key[5] }; // page 12, stores key at location P2
+		ApduResponse response = executeApdu(session, APDU_LoadKey, sizeof(APDU_LoadKey));
+		if (!isSuccessResponse(response, pbRecvBuffer, 0)) {
+			LOG_ERROR("Failed to load provided key. Aborting..");
+			acr_session_forget_key_slots(session);
+			return FALSE;
+		}
+		acr_session_set_key_slot(session, (BYTE)slot, key);
+	}
+
+	// page 13 (0x60 is Key A, 0x61 is key B)
+	// Note: If this APDU does not work it is because your PCSC library is using an old version (<2.07), in such cases the correct command is: { 0xff, 0x88, 0x00, block, keyType, slot } as seen on page 15. On linux see your version using: pcscd --version
+	LOG_INFO("Authenticating block 0x%02x..", block);
+	BYTE APDU_Authenticate_Block[10] = { 0xff, 0x86, 0x00, 0x00, 0x05, 0x01, 0x00, block, keyType, (BYTE)slot };
+	ApduResponse response = executeApdu(session, APDU_Authenticate_Block, sizeof(APDU_Authenticate_Block));
+	if (!isSuccessResponse(response, pbRecvBuffer, 0)) {
+		// the key might not have been in the slot after all (e.g. another pcsc client loaded its own), load it again next time
+		LOG_ERROR("Failed to authenticate block 0x%02x. Aborting..", block);
+		acr_session_forget_key_slots(session);
+		return FALSE;
+	}
+	LOG_INFO("Authenticated block 0x%02x successfully", block);
+	acr_session_set_authenticated(session, sector, keyType, key);
+
+	return TRUE;
+}
+
+// mifare_classic_try_key is mifare_classic_authenticate for a key that might be wrong (trying the keys of a keyset one after the other):
+// a failed authentication halts the tag, so it is selected again right away to give the next key a chance
+BOOL mifare_classic_try_key(BYTE block, int sector, BYTE keyType, const BYTE *key, acr_session *session) {
+	if (mifare_classic_authenticate(block, sector, keyType, key, session)) {
+		return TRUE;
+	}
+	reselectTag(session);
+	return FALSE;
+}
+
+// -------------------------------- sector geometry ---------------------------------
+
+// mifare_classic_geometry_of_tag maps the tag name of getStatus to its geometry, NULL: not a Mifare Classic tag
+const MifareClassicGeometry *mifare_classic_geometry_of_tag(const char *tagName) {
+	for (size_t i = 0; i < sizeof(MIFARE_CLASSIC_GEOMETRIES) / sizeof(MIFARE_CLASSIC_GEOMETRIES[0]); i++) {
+		if (strcmp(tagName, MIFARE_CLASSIC_GEOMETRIES[i]->name) == 0) {
+			return MIFARE_CLASSIC_GEOMETRIES[i];
+		}
+	}
+	return NULL;
+}
+
+// mifare_classic_geometry_of_size returns the geometry of a tag with size bytes of memory, NULL: there is no such tag
+const MifareClassicGeometry *mifare_classic_geometry_of_size(uint32_t size) {
+	for (size_t i = 0; i < sizeof(MIFARE_CLASSIC_GEOMETRIES) / sizeof(MIFARE_CLASSIC_GEOMETRIES[0]); i++) {
+		if (size == MIFARE_CLASSIC_GEOMETRIES[i]->size) {
+			return MIFARE_CLASSIC_GEOMETRIES[i];
+		}
+	}
+	return NULL;
+}
+
+// sectors 0x00 - 0x1F have 4 blocks each (mini / 1k tags end after sector 0x04 / 0x0F), sectors 0x20 - 0x27 of a 4k tag have 16 blocks each
+BYTE mifare_classic_sector_first_block(BYTE sector) {
+	return (sector < 0x20) ? (BYTE)(sector * 4) : (BYTE)(128 + (sector - 0x20) * 16);
+}
+
+// mifare_classic_sector_block_count includes the sector trailer (the last block of every sector)
+BYTE mifare_classic_sector_block_count(BYTE sector) {
+	return (sector < 0x20) ? 4 : 16;
+}
+
+BYTE mifare_classic_sector_trailer_block(BYTE sector) {
+	return (sector < 0x20) ? (BYTE)(sector * 4 + 3) : (BYTE)(128 + (sector - 0x20) * 16 + 15);
+}
+
+BYTE mifare_classic_sector_of_block(BYTE block) {
+	return (block < 128) ? (BYTE)(block / 4) : (BYTE)(0x20 + (block - 128) / 16);
+}
+
+BOOL mifare_classic_is_trailer_block(BYTE block) {
+	return (block < 128) ? ((block & 0x03) == 0x03) : ((block & 0x0F) == 0x0F);
+}
+
+// NDEF formatted tags keep their MAD (Mifare Application Directory) in sector 0x00 and, on 4k tags, in sector 0x10. those sectors have their own keys
+BOOL mifare_classic_is_mad_sector(const MifareClassicGeometry *geometry, BYTE sector) {
+	return (sector == 0x00) || ((sector == 0x10) && (geometry->amountSectors > 0x10));
+}
+
+// mifare_classic_mad_crc is the CRC-8 of a MAD (polynomial 0x1D, preset 0xC7) over the info byte and the application IDs, i.e. everything after the CRC byte
+BYTE mifare_classic_mad_crc(const BYTE *data, size_t length) {
+	BYTE crc = 0xC7;
+	for (size_t i = 0; i < length; i++) {
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x80) ? (BYTE)((crc << 1) ^ 0x1D) : (BYTE)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+// mifare_classic_build_ndef_mad fills in the MAD of an NDEF formatted tag: every sector (except the MAD sectors) holds NDEF data (application ID 03 E1).
+// mad1 is the content of blocks 0x01 - 0x02 (32 bytes), mad2 the content of blocks 0x40 - 0x42 (48 bytes, 4k only)
+static void mifare_classic_build_ndef_mad(const MifareClassicGeometry *geometry, BYTE *mad1, BYTE *mad2) {
+	memset(mad1, 0, 32);
+	mad1[1] = 0x01; // info byte
+	for (BYTE s = 0x01; s < 0x10; s++) {
+		if (s < geometry->amountSectors) {
+			mad1[s * 2] = 0x03;
+			mad1[s * 2 + 1] = 0xE1;
+		}
+	}
+	mad1[0] = mifare_classic_mad_crc(mad1 + 1, 31);
+
+	if (mad2 != NULL) {
+		memset(mad2, 0, 48);
+		mad2[1] = 0x01; // info byte
+		for (BYTE s = 0x11; s < geometry->amountSectors; s++) {
+			mad2[(s - 0x10) * 2] = 0x03;
+			mad2[(s - 0x10) * 2 + 1] = 0xE1;
+		}
+		mad2[0] = mifare_classic_mad_crc(mad2 + 1, 47);
+	}
+}
+
+// -------------------------------- access bits ---------------------------------
+
+// the access bits hold C1, C2 and C3 of the 4 block groups of a sector, each of them twice (once inverted). bit n of every nibble belongs to group n:
+//		byte 6: ~C2 ~C1		byte 7: C1 ~C3		byte 8: C3 C2		(byte 9 is a general purpose byte)
+// a condition is written as C1 C2 C3 (0x03 is "0 1 1"). groups 0 - 2 are the data blocks (5 blocks each in the 16 block sectors), group 3 is the
+// sector trailer. tables as in the Mifare Classic datasheets (MF1S50yyX, chapter 8.7)
+#define ACCESS_NONE	0x00
+#define ACCESS_A	MIFARE_CLASSIC_ACCESS_KEY_A
+#define ACCESS_B	MIFARE_CLASSIC_ACCESS_KEY_B
+#define ACCESS_AB	(MIFARE_CLASSIC_ACCESS_KEY_A | MIFARE_CLASSIC_ACCESS_KEY_B)
+
+// data blocks: read, write, increment, decrement / transfer / restore
+static const BYTE MIFARE_CLASSIC_DATA_ACCESS[8][4] = {
+	{ ACCESS_AB,	ACCESS_AB,	 ACCESS_AB,	  ACCESS_AB },		// 0 0 0 (transport configuration)
+	{ ACCESS_AB,	ACCESS_NONE, ACCESS_NONE, ACCESS_AB },		// 0 0 1 (value block, decrement only)
+	{ ACCESS_AB,	ACCESS_NONE, ACCESS_NONE, ACCESS_NONE },	// 0 1 0 (read only)
+	{ ACCESS_B,		ACCESS_B,	 ACCESS_NONE, ACCESS_NONE },	// 0 1 1
+	{ ACCESS_AB,	ACCESS_B,	 ACCESS_NONE, ACCESS_NONE },	// 1 0 0
+	{ ACCESS_B,		ACCESS_NONE, ACCESS_NONE, ACCESS_NONE },	// 1 0 1
+	{ ACCESS_AB,	ACCESS_B,	 ACCESS_B,	  ACCESS_AB },		// 1 1 0 (value block, recharge with key B)
+	{ ACCESS_NONE,	ACCESS_NONE, ACCESS_NONE, ACCESS_NONE },	// 1 1 1 (blocked)
+};
+
+// sector trailers: write key A, read access bits, write access bits, read key B, write key B (key A can never be read)
+static const BYTE MIFARE_CLASSIC_TRAILER_ACCESS[8][5] = {
+	{ ACCESS_A,		ACCESS_A,	ACCESS_NONE, ACCESS_A,	  ACCESS_A },		// 0 0 0
+	{ ACCESS_A,		ACCESS_A,	ACCESS_A,	 ACCESS_A,	  ACCESS_A },		// 0 0 1 (transport configuration)
+	{ ACCESS_NONE,	ACCESS_A,	ACCESS_NONE, ACCESS_A,	  ACCESS_NONE },	// 0 1 0
+	{ ACCESS_B,		ACCESS_AB,	ACCESS_B,	 ACCESS_NONE, ACCESS_B },		// 0 1 1
+	{ ACCESS_B,		ACCESS_AB,	ACCESS_NONE, ACCESS_NONE, ACCESS_B },		// 1 0 0
+	{ ACCESS_NONE,	ACCESS_AB,	ACCESS_B,	 ACCESS_NONE, ACCESS_NONE },	// 1 0 1
+	{ ACCESS_NONE,	ACCESS_AB,	ACCESS_NONE, ACCESS_NONE, ACCESS_NONE },	// 1 1 0
+	{ ACCESS_NONE,	ACCESS_AB,	ACCESS_NONE, ACCESS_NONE, ACCESS_NONE },	// 1 1 1
+};
+
+// mifare_classic_access_bits_decode splits the 3 access bytes (bytes 6 - 8 of a sector trailer) into the conditions of the 4 block groups.
+// returns FALSE if the inverted copies do not match: a tag treats such a sector as blocked for good
+BOOL mifare_classic_access_bits_decode(const BYTE *accessBits, BYTE *conditions) {
+	BYTE c1 = accessBits[1] >> 4;
+	BYTE c2 = accessBits[2] & 0x0F;
+	BYTE c3 = accessBits[2] >> 4;
+	if (((accessBits[0] & 0x0F) != (~c1 & 0x0F)) || ((accessBits[0] >> 4) != (~c2 & 0x0F)) || ((accessBits[1] & 0x0F) != (~c3 & 0x0F))) {
+		return FALSE;
+	}
+
+	for (int group = 0; group < 4; group++) {
+		conditions[group] = (BYTE)((((c1 >> group) & 1) << 2) | (((c2 >> group) & 1) << 1) | ((c3 >> group) & 1));
+	}
+	return TRUE;
+}
+
+// mifare_classic_access_bits_encode is the reverse of mifare_classic_access_bits_decode (writes 3 bytes, the general purpose byte is left alone)
+void mifare_classic_access_bits_encode(const BYTE *conditions, BYTE *accessBits) {
+	BYTE c1 = 0, c2 = 0, c3 = 0;
+	for (int group = 0; group < 4; group++) {
+		c1 |= (BYTE)(((conditions[group] >> 2) & 1) << group);
+		c2 |= (BYTE)(((conditions[group] >> 1) & 1) << group);
+		c3 |= (BYTE)((conditions[group] & 1) << group);
+	}
+	accessBits[0] = (BYTE)(((~c2 & 0x0F) << 4) | (~c1 & 0x0F));
+	accessBits[1] = (BYTE)((c1 << 4) | (~c3 & 0x0F));
+	accessBits[2] = (BYTE)((c3 << 4) | c2);
+}
+
+// mifare_classic_group_access looks up which keys may do op on the blocks of group
+static BYTE mifare_classic_group_access(const BYTE *conditions, int group, MifareClassicAccessOp op) {
+	const BYTE *trailer = MIFARE_CLASSIC_TRAILER_ACCESS[conditions[MIFARE_CLASSIC_ACCESS_GROUP_TRAILER] & 0x07];
+	BYTE keys;
+
+	if (group != MIFARE_CLASSIC_ACCESS_GROUP_TRAILER) {
+		keys = (op <= MIFARE_CLASSIC_ACCESS_DECREMENT) ? MIFARE_CLASSIC_DATA_ACCESS[conditions[group] & 0x07][op] : ACCESS_NONE;
+	} else {
+		switch (op) {
+			case MIFARE_CLASSIC_ACCESS_READ:				keys = trailer[1]; break;
+			case MIFARE_CLASSIC_ACCESS_WRITE:				keys = trailer[0] & trailer[2] & trailer[4]; break;
+			case MIFARE_CLASSIC_ACCESS_WRITE_KEY_A:			keys = trailer[0]; break;
+			case MIFARE_CLASSIC_ACCESS_WRITE_ACCESS_BITS:	keys = trailer[2]; break;
+			case MIFARE_CLASSIC_ACCESS_READ_KEY_B:			keys = trailer[3]; break;
+			case MIFARE_CLASSIC_ACCESS_WRITE_KEY_B:			keys = trailer[4]; break;
+			default:										keys = ACCESS_NONE; break;
+		}
+	}
+
+	// if key A may read key B, key B is plain data and can not be used to authenticate at all
+	if (trailer[3] != ACCESS_NONE) {
+		keys &= (BYTE)~ACCESS_B;
+	}
+	return keys;
+}
+
+// mifare_classic_access_keys tells which keys (MIFARE_CLASSIC_ACCESS_KEY_A / _KEY_B mask, 0: none) may do op on block, conditions as decoded by
+// mifare_classic_access_bits_decode from the trailer of the sector that holds block
+BYTE mifare_classic_access_keys(const BYTE *conditions, BYTE block, MifareClassicAccessOp op) {
+	BYTE sector = mifare_classic_sector_of_block(block);
+	BYTE offset = block - mifare_classic_sector_first_block(sector);
+	int group;
+	if (mifare_classic_is_trailer_block(block)) {
+		group = MIFARE_CLASSIC_ACCESS_GROUP_TRAILER;
+	} else {
+		group = (sector < 0x20) ? offset : offset / 5;
+	}
+	return mifare_classic_group_access(conditions, group, op);
+}
+
+// mifare_classic_access_key_type picks the key type (MIFARE_CLASSIC_KEY_A / _KEY_B) to do op on block with: preferred if it is allowed to (e.g. the key
+// the sector already is authenticated with, so no authentication is needed), otherwise the other one. 0: no key may do it, or the access bits are malformed.
+// knowing this up front saves the authentication and the APDU that the tag would reject anyway
+BYTE mifare_classic_access_key_type(const BYTE *accessBits, BYTE block, MifareClassicAccessOp op, BYTE preferred) {
+	BYTE conditions[4];
+	if (!mifare_classic_access_bits_decode(accessBits, conditions)) {
+		return 0;
+	}
+	BYTE keys = mifare_classic_access_keys(conditions, block, op);
+	BYTE other = (preferred == MIFARE_CLASSIC_KEY_A) ? MIFARE_CLASSIC_KEY_B : MIFARE_CLASSIC_KEY_A;
+	BYTE preferredBit = (preferred == MIFARE_CLASSIC_KEY_A) ? ACCESS_A : ACCESS_B;
+
+	if (keys & preferredBit) {
+		return preferred;
+	}
+	if (keys & (ACCESS_AB & ~preferredBit)) {
+		return other;
+	}
+	return 0;
+}
+
+// mifare_classic_check_trailer refuses sector trailers that would make the sector unusable: malformed access bits block the sector for good.
+// unless allowIrreversible, trailers after which no key can ever change the access bits again are refused as well
+BOOL mifare_classic_check_trailer(const BYTE *trailer, BOOL allowIrreversible) {
+	BYTE conditions[4];
+	if (!mifare_classic_access_bits_decode(trailer + 6, conditions)) {
+		LOG_ERROR("Refusing to write sector trailer with malformed access bits %02x %02x %02x (the inverted bits do not match), it would block the sector for good.",
+			trailer[6], trailer[7], trailer[8]);
+		return FALSE;
+	}
+	if (!allowIrreversible && (mifare_classic_group_access(conditions, MIFARE_CLASSIC_ACCESS_GROUP_TRAILER, MIFARE_CLASSIC_ACCESS_WRITE_ACCESS_BITS) == ACCESS_NONE)) {
+		LOG_ERROR("Refusing to write sector trailer with access bits %02x %02x %02x, no key could ever change them again.", trailer[6], trailer[7], trailer[8]);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+#undef ACCESS_NONE
+#undef ACCESS_A
+#undef ACCESS_B
+#undef ACCESS_AB
+
+// -------------------------------- sector read / write ---------------------------------
+
+// mifare_classic_read_authenticated_block reads the 16 bytes of a block of the sector that currently is authenticated (see mifare_classic_authenticate)
+static BOOL mifare_classic_read_authenticated_block(BYTE block, BYTE *data, acr_session *session) {
+	BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
+
+	//SLEEP_CUSTOM(2000); // page 16 notes to wait 2 sec on mifare classic 4k, however i never had issues without it
+
+	BYTE APDU_Read[5] = { 0xff, 0xb0, 0x00, block, 0x10 }; // page 16 of ACR122U_APIDriverManual.pdf (reads 16 bytes, and the page number is a coincidence)
+	LOG_DEBUG("Reading block 0x%02x..", block);
+	ApduResponse response = executeApdu(session, APDU_Read, sizeof(APDU_Read));
+	if (!isSuccessResponse(response, pbRecvBuffer, 16)) {
+		LOG_ERROR("Failed to read data from block 0x%02x. Aborting..", block);
+		return FALSE;
+	}
+	memcpy(data, pbRecvBuffer, 16);
+	return TRUE;
+}
+
+// mifare_classic_read_sector_blocks reads all data blocks of a sector (not the sector trailer) into blocks (16 bytes per block: 3 blocks, or 15 in sectors 0x20 - 0x27)
+// the sector is authenticated once and then all blocks are read back to back. nothing is printed
+BOOL mifare_classic_read_sector_blocks(BYTE sector, BYTE keyType, const BYTE *key, BYTE *blocks, acr_session *session) {
+	BYTE firstBlock = mifare_classic_sector_first_block(sector);
+	BYTE dataBlocks = mifare_classic_sector_block_count(sector) - 1;
+
+	if (!mifare_classic_authenticate(firstBlock, sector, keyType, key, session)) {
+		return FALSE;
+	}
+	for (BYTE i = 0; i < dataBlocks; i++) {
+		if (!mifare_classic_read_authenticated_block(firstBlock + i, blocks + i * 16, session)) {
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+// mifare_classic_write_authenticated_block writes 16 bytes to a block of the sector that currently is authenticated (see mifare_classic_authenticate).
+// sector trailers are written as they are, unchecked (see mifare_classic_check_trailer)
+BOOL mifare_classic_write_authenticated_block(BYTE block, const BYTE *data, acr_session *session) {
+	BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
+	BYTE APDU_Write[5 + 16] = { 0xff, 0xd6, 0x00, block, 0x10 };	// base command 5 bytes + 16 byte to write to block
+	memcpy(APDU_Write + 5, data, 16);
+	ApduResponse response = executeApdu(session, APDU_Write, sizeof(APDU_Write));
+	if (!isSuccessResponse(response, pbRecvBuffer, 0)) {
+		LOG_ERROR("Failed to write to block 0x%02x. Aborting..", block);
+		return FALSE;
+	}
+	LOG_DEBUG("Wrote data to block 0x%02x with success.", block);
+	return TRUE;
+}
+
+// mifare_classic_write_sector writes all data blocks of a sector (blocks: 16 bytes per data block like in mifare_classic_read_sector_blocks, NULL: leave them alone)
+// and then the sector trailer (NULL: leave it alone). the sector is authenticated once, block 0 (manufacturer block) is never written.
+// the trailer comes last because it may change the keys / access bits that the data writes rely on. it is checked before anything is written
+// (see mifare_classic_check_trailer), a sector trailer that freezes the access bits can only be written with mifare_classic_write_authenticated_block
+static BOOL do_mifare_classic_write_sector(BYTE sector, BYTE keyType, const BYTE *key, const BYTE *blocks, const BYTE *trailer, acr_session *session) {
+	BYTE firstBlock = mifare_classic_sector_first_block(sector);
+	BYTE dataBlocks = mifare_classic_sector_block_count(sector) - 1;
+
+	if ((trailer != NULL) && !mifare_classic_check_trailer(trailer, FALSE)) {
+		return FALSE;
+	}
+	if (!mifare_classic_authenticate(firstBlock, sector, keyType, key, session)) {
+		return FALSE;
+	}
+
+	if (blocks != NULL) {
+		for (BYTE i = 0; i < dataBlocks; i++) {
+			BYTE block = firstBlock + i;
+			if (block == 0x00) continue; // block 0 is not writable
+			if (!mifare_classic_write_authenticated_block(block, blocks + i * 16, session)) {
+				return FALSE;
+			}
+		}
+	}
+
+	if (trailer != NULL) {
+		BYTE trailerBlock = mifare_classic_sector_trailer_block(sector);
+		if (!mifare_classic_write_authenticated_block(trailerBlock, trailer, session)) {
+			return FALSE;
+		}
+		LOG_INFO("Wrote new sector trailer 0x%02x", trailerBlock);
+	}
+
+	return TRUE;
+}
+
+BOOL mifare_classic_write_sector(BYTE sector, BYTE keyType, const BYTE *key, const BYTE *blocks, const BYTE *trailer, acr_session *session) {
+	return ACR_SESSION_OPERATION(session, do_mifare_classic_write_sector(sector, keyType, key, blocks, trailer, session));
+}
+
+// -------------------------------- full card dump ---------------------------------
+
+// the well known keys of uninitialized and NDEF formatted tags, all tried as key A
+static const MifareClassicKey MIFARE_CLASSIC_DEFAULT_KEYS[] = {
+	{ MIFARE_CLASSIC_KEY_A, { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF } },	// uninitialized
+	{ MIFARE_CLASSIC_KEY_A, { 0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7 } },	// NDEF sectors
+	{ MIFARE_CLASSIC_KEY_A, { 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 } },	// NDEF MAD sectors (see mifare_classic_is_mad_sector)
+};
+const MifareClassicKeyset MIFARE_CLASSIC_DEFAULT_KEYSET = { MIFARE_CLASSIC_DEFAULT_KEYS, sizeof(MIFARE_CLASSIC_DEFAULT_KEYS) / sizeof(MIFARE_CLASSIC_DEFAULT_KEYS[0]) };
+
+// mifare_classic_image_sector_ok tells whether sector made it into the image
+BOOL mifare_classic_image_sector_ok(const MifareClassicImage *image, BYTE sector) {
+	return (sector < MIFARE_CLASSIC_MAX_SECTORS) && ((image->sectorsRead >> sector) & 1);
+}
+
+// mifare_classic_keyset_source is the MifareClassicKeySource of a plain keyset: its keys are tried in order until one authenticates sector
+BOOL mifare_classic_keyset_source(void *ctx, BYTE sector, MifareClassicKey *key, acr_session *session) {
+	const MifareClassicKeyset *keyset = (const MifareClassicKeyset *)ctx;
+	BYTE firstBlock = mifare_classic_sector_first_block(sector);
+
+	for (size_t k = 0; k < keyset->amountKeys; k++) {
+		const MifareClassicKey *candidate = &keyset->keys[k];
+		if (mifare_classic_try_key(firstBlock, sector, candidate->keyType, candidate->key, session)) {
+			*key = *candidate;
+			return TRUE;
+		}
+		// wrong key, try the next one
+	}
+
+	LOG_WARN("None of the %u keys can authenticate sector 0x%02x", (unsigned int)keyset->amountKeys, sector);
+	return FALSE;
+}
+
+// mifare_classic_dump_sector lets source authenticate sector, then reads all of its blocks into the image. the trailer is read first:
+// if its access bits do not let the key read every data block, the sector is given up without sending reads the tag would reject
+static BOOL mifare_classic_dump_sector(MifareClassicKeySource source, void *ctx, MifareClassicImage *image, BYTE sector, acr_session *session) {
+	BYTE firstBlock = mifare_classic_sector_first_block(sector);
+	BYTE trailerBlock = mifare_classic_sector_trailer_block(sector);
+
+	MifareClassicKey key;
+	if (!source(ctx, sector, &key, session)) {
+		return FALSE;
+	}
+
+	BYTE *trailer = image->data + trailerBlock * 16;
+	if (!mifare_classic_read_authenticated_block(trailerBlock, trailer, session)) {
+		return FALSE;
+	}
+	for (BYTE block = firstBlock; block < trailerBlock; block++) {
+		if (mifare_classic_access_key_type(trailer + 6, block, MIFARE_CLASSIC_ACCESS_READ, key.keyType) != key.keyType) {
+			LOG_WARN("The access bits of sector 0x%02x do not let key %c read block 0x%02x", sector, (key.keyType == MIFARE_CLASSIC_KEY_A) ? 'A' : 'B', block);
+			return FALSE;
+		}
+		if (!mifare_classic_read_authenticated_block(block, image->data + block * 16, session)) {
+			return FALSE;
+		}
+	}
+
+	// key A can never be read back (the tag returns zeroes), put in the one that worked so that the image can be written back as it is.
+	// a sector read with key B gets key B put in instead, its key A stays unknown (zeroes, see mifare_classic_write_changed_blocks)
+	memcpy(trailer + ((key.keyType == MIFARE_CLASSIC_KEY_A) ? 0 : 10), key.key, 6);
+	image->sectorKeys[sector] = key;
+	return TRUE;
+}
+
+// mifare_classic_dump_with reads every sector of the tag into image (image->size: 320, 1024 or 4096, 0: decide based on acr_session_tag_name),
+// source picks the key of every sector (see mifare_classic_keyset_source and mifare-classic-resolver.h).
+// sectors that can not be read are skipped (their bit in image->sectorsRead stays 0, the data stays zeroed). sectorDone (may be NULL) is called
+// right after each sector, so the caller can start working with a sector while the rest of the tag is still being read. nothing is printed.
+// returns TRUE if every sector was read
+static BOOL do_mifare_classic_dump_with(MifareClassicKeySource source, void *ctx, MifareClassicImage *image, MifareClassicSectorCallback sectorDone, void *arg, acr_session *session) {
+	const MifareClassicGeometry *geometry = (image->size == 0) ? mifare_classic_geometry_of_tag(acr_session_tag_name(session)) : mifare_classic_geometry_of_size(image->size);
+	if (geometry == NULL) {
+		LOG_WARN("Can not dump this tag: it is no Mifare Classic tag, or the image size (%u bytes) is not 320, 1024 or 4096 bytes.", (unsigned int)image->size);
+		return FALSE;
+	}
+	memset(image->data, 0, sizeof(image->data));
+	memset(image->sectorKeys, 0, sizeof(image->sectorKeys));
+	image->sectorsRead = 0;
+	image->size = geometry->size;
+	image->amountSectors = geometry->amountSectors;
+
+	BOOL complete = TRUE;
+	for (BYTE s = 0; s < image->amountSectors; s++) {
+		BOOL success = mifare_classic_dump_sector(source, ctx, image, s, session);
+		if (success) {
+			image->sectorsRead |= (uint64_t)1 << s;
+		} else {
+			complete = FALSE;
+		}
+		if (sectorDone != NULL) {
+			sectorDone(image, s, success, arg);
+		}
+	}
+
+	return complete;
+}
+
+BOOL mifare_classic_dump_with(MifareClassicKeySource source, void *ctx, MifareClassicImage *image, MifareClassicSectorCallback sectorDone, void *arg, acr_session *session) {
+	return ACR_SESSION_OPERATION(session, do_mifare_classic_dump_with(source, ctx, image, sectorDone, arg, session));
+}
+
+// mifare_classic_dump tries the keys of keyset on every sector, see mifare_classic_dump_with
+BOOL mifare_classic_dump(const MifareClassicKeyset *keyset, MifareClassicImage *image, MifareClassicSectorCallback sectorDone, void *arg, acr_session *session) {
+	return mifare_classic_dump_with(mifare_classic_keyset_source, (void *)keyset, image, sectorDone, arg, session);
+}
+
+// -------------------------------- image diff write ---------------------------------
+
+// mifare_classic_find_write_key authenticates sector with a key of keyset (may be NULL) whose type is in keys (MIFARE_CLASSIC_ACCESS_KEY_A / _KEY_B mask),
+// for sectors whose access bits do not let the key that read the sector write to it
+static BOOL mifare_classic_find_write_key(const MifareClassicKeyset *keyset, BYTE keys, BYTE sector, acr_session *session) {
+	for (size_t k = 0; (keyset != NULL) && (k < keyset->amountKeys); k++) {
+		const MifareClassicKey *candidate = &keyset->keys[k];
+		BYTE bit = (candidate->keyType == MIFARE_CLASSIC_KEY_A) ? MIFARE_CLASSIC_ACCESS_KEY_A : MIFARE_CLASSIC_ACCESS_KEY_B;
+		if ((keys & bit) && mifare_classic_try_key(mifare_classic_sector_first_block(sector), sector, candidate->keyType, candidate->key, session)) {
+			return TRUE;
+		}
+	}
+
+	LOG_ERROR("The access bits of sector 0x%02x only let key %s write the changed blocks, and no such key of the keyset authenticates it. Aborting..",
+		sector, (keys == MIFARE_CLASSIC_ACCESS_KEY_A) ? "A" : ((keys == MIFARE_CLASSIC_ACCESS_KEY_B) ? "B" : "A or B"));
+	return FALSE;
+}
+
+// mifare_classic_write_changed_blocks writes the blocks of sector in which target differs from current, under a single authentication: the key that read
+// the sector if the access bits of the sector let it write all of those blocks, otherwise a key of keyset that may. the trailer comes last so that the
+// keys / access bits stay valid for the data writes, and it is checked before anything is written. current is updated along the way
+static BOOL mifare_classic_write_changed_blocks(const MifareClassicKeyset *keyset, const MifareClassicImage *target, MifareClassicImage *current, BYTE sector, acr_session *session) {
+	BYTE firstBlock = mifare_classic_sector_first_block(sector);
+	BYTE trailerBlock = mifare_classic_sector_trailer_block(sector);
+
+	// find the changed blocks first, and the keys that may write all of them
+	BYTE conditions[4];
+	BOOL accessKnown = mifare_classic_access_bits_decode(current->data + trailerBlock * 16 + 6, conditions);
+	BYTE keys = MIFARE_CLASSIC_ACCESS_KEY_A | MIFARE_CLASSIC_ACCESS_KEY_B;
+	BOOL changed = FALSE;
+	for (int block = firstBlock; block <= trailerBlock; block++) { // not BYTE: the last trailer of a 4k tag is block 0xFF
+		if (memcmp(target->data + block * 16, current->data + block * 16, 16) == 0) {
+			continue;
+		}
+		if (block == 0x00) {
+			LOG_WARN("Block 0x00 (manufacturer block) differs from the target image but is not writable, skipping it");
+			continue;
+		}
+		changed = TRUE;
+		if (accessKnown) {
+			keys &= mifare_classic_access_keys(conditions, (BYTE)block, MIFARE_CLASSIC_ACCESS_WRITE);
+		}
+	}
+	if (!changed) {
+		return TRUE;
+	}
+	if (!mifare_classic_image_sector_ok(current, sector)) {
+		LOG_ERROR("Sector 0x%02x has changes, but its current content is unknown. Aborting..", sector);
+		return FALSE;
+	}
+	const BYTE *wantedTrailer = target->data + trailerBlock * 16;
+	if ((memcmp(wantedTrailer, current->data + trailerBlock * 16, 16) != 0) && !mifare_classic_check_trailer(wantedTrailer, FALSE)) {
+		return FALSE;
+	}
+
+	MifareClassicKey *key = &current->sectorKeys[sector];
+	if ((key->keyType == MIFARE_CLASSIC_KEY_B) && (memcmp(wantedTrailer, current->data + trailerBlock * 16, 16) != 0) &&
+		(memcmp(wantedTrailer, current->data + trailerBlock * 16, 6) == 0)) {
+		// the key A bytes in the trailer of current are the zeroes the tag returned, writing them would silently re-key the sector to key A 00 00 00 00 00 00
+		LOG_ERROR("Sector 0x%02x was read with key B, so its key A is unknown. Put the wanted key A into the new sector trailer of the target image. Aborting..", sector);
+		return FALSE;
+	}
+	BYTE keyBit = (key->keyType == MIFARE_CLASSIC_KEY_A) ? MIFARE_CLASSIC_ACCESS_KEY_A : MIFARE_CLASSIC_ACCESS_KEY_B;
+	if (keys == 0) {
+		LOG_ERROR("The access bits of sector 0x%02x do not let any key write all of the changed blocks. Aborting..", sector);
+		return FALSE;
+	}
+	if (keys & keyBit) {
+		if (!mifare_classic_authenticate(firstBlock, sector, key->keyType, key->key, session)) {
+			return FALSE;
+		}
+	} else if (!mifare_classic_find_write_key(keyset, keys, sector, session)) {
+		return FALSE;
+	}
+
+	for (int block = firstBlock; block <= trailerBlock; block++) {
+		const BYTE *wanted = target->data + block * 16;
+		BYTE *present = current->data + block * 16;
+		if ((block == 0x00) || (memcmp(wanted, present, 16) == 0)) {
+			continue;
+		}
+		if (!mifare_classic_write_authenticated_block((BYTE)block, wanted, session)) {
+			return FALSE;
+		}
+		memcpy(present, wanted, 16);
+
+		if (block == trailerBlock) {
+			// the keys might have changed, later accesses of this sector have to authenticate with the new ones
+			memcpy(key->key, (key->keyType == MIFARE_CLASSIC_KEY_A) ? wanted : wanted + 10, 6);
+			acr_session_forget_authentication(session);
+			LOG_INFO("Wrote new sector trailer 0x%02x", trailerBlock);
+		}
+	}
+
+	return TRUE;
+}
+
+// mifare_classic_write_image makes the tag look like target while writing as few blocks as possible: only blocks that differ from current are written,
+// grouped by sector (one authentication per changed sector, sector trailer last). current is the content of the tag as returned by mifare_classic_dump,
+// NULL: read it first using keyset. a supplied current is updated to the new content of the tag, so it can be used for the next update right away.
+// keyset is also where the key comes from if the access bits of a sector only let the other key type write it (e.g. key B of NDEF MAD sectors)
+static BOOL do_mifare_classic_write_image(const MifareClassicKeyset *keyset, const MifareClassicImage *target, MifareClassicImage *current, acr_session *session) {
+	const MifareClassicGeometry *geometry = mifare_classic_geometry_of_size(target->size);
+	if (geometry == NULL) {
+		LOG_ERROR("Target image size (%u bytes) is not 320, 1024 or 4096 bytes. Aborting..", (unsigned int)target->size);
+		return FALSE;
+	}
+
+	MifareClassicImage readImage = {0};
+	if (current == NULL) {
+		readImage.size = target->size;
+		mifare_classic_dump(keyset, &readImage, NULL, NULL, session); // sectors that could not be read only matter if they have changes
+		if (readImage.amountSectors != geometry->amountSectors) {
+			LOG_ERROR("Failed to read the current content of the tag. Aborting..");
+			return FALSE;
+		}
+		current = &readImage;
+	}
+	if ((current->size != target->size) || (current->amountSectors != geometry->amountSectors)) {
+		LOG_ERROR("Target image (%u bytes) and current image (%u bytes) are not of the same tag type. Aborting..", (unsigned int)target->size, (unsigned int)current->size);
+		return FALSE;
+	}
+
+	for (BYTE s = 0; s < geometry->amountSectors; s++) {
+		if (!mifare_classic_write_changed_blocks(keyset, target, current, s, session)) {
+			LOG_ERROR("Failed to update sector 0x%02x. Aborting..", s);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+BOOL mifare_classic_write_image(const MifareClassicKeyset *keyset, const MifareClassicImage *target, MifareClassicImage *current, acr_session *session) {
+	return ACR_SESSION_OPERATION(session, do_mifare_classic_write_image(keyset, target, current, session));
+}
+
+// -------------------------------- tag API ---------------------------------
+
+// mifare_classic_read_sector reads all data blocks in a sector (does not read sector trailer) and prints it
+static SectorContent do_mifare_classic_read_sector(const MifareClassicGeometry *geometry, BYTE sectorId, const BYTE *keyA, acr_session *session) {
+	// prepare data type that holds the data that will be returned on success
+	SectorContent sector_content = {0}; // initialize all fields to 0, when you return early due to error just set false as .status
+	sector_content.sectorID = sectorId;
+
+	// check whether passed sector is valid for this tag
+	if (sectorId >= geometry->amountSectors) {
+		LOG_WARN("0x%02x is not a valid sector! You can only read sectors [0x00, 0x%02x] of a %s.", sectorId, geometry->amountSectors - 1, geometry->name);
+		sector_content.status = FALSE;
+		return sector_content;
+	}
+
+	// chosen sector contains either 4 blocks or 16 blocks (one of which is the sector trailer)
+	LOG_INFO("Authenticating and reading blocks in sector %d..", sectorId);
+	if (!mifare_classic_read_sector_blocks(sectorId, MIFARE_CLASSIC_KEY_A, keyA, &sector_content.blocks[0][0], session)) {
+		sector_content.status = FALSE;
+		return sector_content;
+	}
+	sector_content.amountBlocks = mifare_classic_sector_block_count(sectorId) - 1;
+
+	BYTE base = mifare_classic_sector_first_block(sectorId);
+	for (BYTE i = 0; i < sector_content.amountBlocks; i++) {
+		printf("Block 0x%02x:", base + i);
+		for (int j = 0; j < 16; j++) {
+			printf(" %02x", sector_content.blocks[i][j]);
+		}
+		printf("\n");
+	}
+
+	sector_content.status = TRUE;
+	return sector_content;
+}
+
+// mifare_classic_read_sector returns a SectorContent, which ACR_SESSION_OPERATION cannot pass through, so it opens and closes its operation itself
+SectorContent mifare_classic_read_sector(const MifareClassicGeometry *geometry, BYTE sectorId, const BYTE *keyA, acr_session *session) {
+	acr_session_begin_operation(session, __func__);
+	SectorContent sector_content = do_mifare_classic_read_sector(geometry, sectorId, keyA, session);
+	acr_session_end_operation(session, sector_content.status);
+	return sector_content;
+}
+
+// currently only supports authentication via keyA
+static BOOL do_mifare_classic_write_block(const MifareClassicGeometry *geometry, const BYTE *BlockData, BYTE block, const BYTE *keyA, acr_session *session) {
+	// sanity checks
+	if (block == 0x00) {
+		LOG_WARN("You can't write to block 0, try a different block.");
+		return FALSE;
+	}
+	if (block >= geometry->amountBlocks) {
+		LOG_WARN("You can't write to block 0x%02x, the last block of a %s is block 0x%02x.", block, geometry->name, geometry->amountBlocks - 1);
+		return FALSE;
+	}
+
+	// warn user if he is writing to sector trailer (allowed but has consequences)
+	if (mifare_classic_is_trailer_block(block)) {
+		LOG_WARN("You have chosen block 0x%02x, this is allowed but keep in mind that this is a sector trailer block.", block);
+		if (!mifare_classic_check_trailer(BlockData, FALSE)) {
+			return FALSE;
+		}
+	}
+
+	// authenticate block (skipped if the caller's operation already authenticated this sector with the same key, see mifare_classic_authenticate)
+	if (!mifare_classic_authenticate(block, mifare_classic_sector_of_block(block), MIFARE_CLASSIC_KEY_A, keyA, session)) {
+		return FALSE;
+	}
+
+	// write data to block
+	if (!mifare_classic_write_authenticated_block(block, BlockData, session)) {
+		return FALSE;
+	}
+	LOG_INFO("Wrote data to block 0x%02x with success.", block);
+
+	return TRUE;
+}
+
+BOOL mifare_classic_write_block(const MifareClassicGeometry *geometry, const BYTE *BlockData, BYTE block, const BYTE *keyA, acr_session *session) {
+	return ACR_SESSION_OPERATION(session, do_mifare_classic_write_block(geometry, BlockData, block, keyA, session));
+}
+
+// this function resets all writable data blocks (so it skips sector trailers) to all zeroes
+// assumes card is using same key A for every block (e.g. would be true for uninitialized card), or is fully NDEF formatted (pass KEY_A_NDEF_SECTOR)
+static BOOL do_mifare_classic_reset_card(const MifareClassicGeometry *geometry, const BYTE *keyA, acr_session *session) {
+	// detect whether passed key is for NDEF sectors. its an edge case cuz then the MAD sectors have a different key
+	BOOL is_NDEF_key = (memcmp(keyA, KEY_A_NDEF_SECTOR, 6) == 0);
+
+	const BYTE Zeroes[MIFARE_CLASSIC_MAX_DATA_BLOCKS * 16] = {0};
+	for (BYTE s = 0x00; s < geometry->amountSectors; s++) {
+		// edge case: if card is ndef formatted, then the MAD sectors have a different key and their access bits (1 0 0) only let key B write the data blocks
+		BOOL ndefMadSector = mifare_classic_is_mad_sector(geometry, s) && is_NDEF_key;
+		const BYTE *accessBits = ACCESS_BITS_UNINITIALIZED;
+		if (is_NDEF_key) {
+			accessBits = ndefMadSector ? ACCESS_BITS_NDEF_MAD_SECTOR : ACCESS_BITS_NDEF_SECTOR;
+		}
+		BYTE keyType = mifare_classic_access_key_type(accessBits, mifare_classic_sector_first_block(s) + 1, MIFARE_CLASSIC_ACCESS_WRITE, MIFARE_CLASSIC_KEY_A);
+		const BYTE *key = (keyType == MIFARE_CLASSIC_KEY_B) ? KEY_B_NDEF_MAD_SECTOR : keyA;
+
+		if (!mifare_classic_write_sector(s, keyType, key, Zeroes, NULL, session)) {
+			LOG_ERROR("Failed to reset sector 0x%02x. Aborting..", s);
+			return FALSE;
+		}
+		LOG_INFO("Reset sector 0x%02x to all zeroes", s);
+	}
+
+	LOG_INFO("Successfully reset entire tag.");
+	return TRUE;
+}
+
+BOOL mifare_classic_reset_card(const MifareClassicGeometry *geometry, const BYTE *keyA, acr_session *session) {
+	return ACR_SESSION_OPERATION(session, do_mifare_classic_reset_card(geometry, keyA, session));
+}
+
+// wipes the data blocks and rewrites the sector trailer of every sector in one pass (one authentication per sector).
+// key B is allowed to write both the data blocks and the trailer of NDEF formatted sectors (access bits 78 77 88 and 7F 07 88)
+static BOOL do_mifare_classic_ndef_to_uninitialized(const MifareClassicGeometry *geometry, acr_session *session) {
+	const BYTE Zeroes[MIFARE_CLASSIC_MAX_DATA_BLOCKS * 16] = {0};
+	for (BYTE s = 0x00; s < geometry->amountSectors; s++) {
+		const BYTE *keyB = mifare_classic_is_mad_sector(geometry, s) ? KEY_B_NDEF_MAD_SECTOR : KEY_B_NDEF_SECTOR;
+		if (!mifare_classic_write_sector(s, MIFARE_CLASSIC_KEY_B, keyB, Zeroes, UNINITIALIZED_SECTOR_TRAILER, session)) {
+			LOG_ERROR("Failed to reset sector 0x%02x of NDEF-formatted tag..", s);
+			return FALSE;
+		}
+	}
+
+	LOG_INFO("Successfully reset the tag back to uninitialized");
+	return TRUE;
+}
+
+BOOL mifare_classic_ndef_to_uninitialized(const MifareClassicGeometry *geometry, acr_session *session) {
+	return ACR_SESSION_OPERATION(session, do_mifare_classic_ndef_to_uninitialized(geometry, session));
+}
+
+// writes the MAD (blocks 0x01 - 0x02, and 0x40 - 0x42 on 4k tags), the empty NDEF message (block 0x04), zeroes into every other data block
+// and the NDEF sector trailers in one pass (one authentication per sector)
+static BOOL do_mifare_classic_uninitialized_to_ndef(const MifareClassicGeometry *geometry, acr_session *session) {
+	BYTE mad1[2 * 16];
+	BYTE mad2[3 * 16];
+	mifare_classic_build_ndef_mad(geometry, mad1, (geometry->amountSectors > 0x10) ? mad2 : NULL);
+
+	for (BYTE s = 0x00; s < geometry->amountSectors; s++) {
+		BYTE blocks[MIFARE_CLASSIC_MAX_DATA_BLOCKS * 16] = {0};
+		if (s == 0x00) {
+			memcpy(blocks + 1 * 16, mad1, sizeof(mad1)); // block 0 is the manufacturer block
+		} else if (s == 0x01) {
+			memcpy(blocks, NDEF_EMPTY_MESSAGE_BLOCK, 16);
+		} else if (s == 0x10) {
+			memcpy(blocks, mad2, sizeof(mad2));
+		}
+		const BYTE *trailer = mifare_classic_is_mad_sector(geometry, s) ? NDEF_MAD_SECTOR_TRAILER : NDEF_SECTOR_TRAILER;
+
+		if (!mifare_classic_write_sector(s, MIFARE_CLASSIC_KEY_A, KEY_A_DEFAULT, blocks, trailer, session)) {
+			LOG_ERROR("Failed to NDEF-format sector 0x%02x of uninitialized tag..", s);
+			return FALSE;
+		}
+	}
+
+	LOG_INFO("Successfully NDEF-formatted the tag");
+	return TRUE;
+}
+
+BOOL mifare_classic_uninitialized_to_ndef(const MifareClassicGeometry *geometry, acr_session *session) {
+	return ACR_SESSION_OPERATION(session, do_mifare_classic_uninitialized_to_ndef(geometry, session));
+}
+
+// -------------------------------- NDEF ---------------------------------
+
+// mifare_classic_read_mad reads the MAD of madSector (0x00: MAD1 in blocks 0x01 - 0x02, 0x10: MAD2 in blocks 0x40 - 0x42, 4k only) and marks the
+// sectors that it assigns to NDEF (application ID E1 03, stored as 03 E1) in ndefSectors
+static BOOL mifare_classic_read_mad(BYTE madSector, BOOL *ndefSectors, acr_session *session) {
+	BYTE mad[3 * 16];
+	BYTE firstBlock = (madSector == 0x00) ? 0x01 : mifare_classic_sector_first_block(madSector);
+	size_t size = (madSector == 0x00) ? 2 * 16 : 3 * 16;
+
+	if (!mifare_classic_authenticate(firstBlock, madSector, MIFARE_CLASSIC_KEY_A, KEY_A_NDEF_MAD_SECTOR, session)) {
+		LOG_WARN("Can not read the MAD in sector 0x%02x with the public MAD key, the tag does not seem to be NDEF formatted.", madSector);
+		return FALSE;
+	}
+	for (size_t i = 0; i < size / 16; i++) {
+		if (!mifare_classic_read_authenticated_block((BYTE)(firstBlock + i), mad + i * 16, session)) {
+			return FALSE;
+		}
+	}
+	if (mifare_classic_mad_crc(mad + 1, size - 1) != mad[0]) {
+		LOG_ERROR("The MAD in sector 0x%02x is corrupt (CRC 0x%02x, expected 0x%02x). Aborting..", madSector, mad[0], mifare_classic_mad_crc(mad + 1, size - 1));
+		return FALSE;
+	}
+
+	BYTE sector = madSector + 1;
+	for (size_t i = 2; i < size; i += 2, sector++) {
+		ndefSectors[sector] = (mad[i] == 0x03) && (mad[i + 1] == 0xE1);
+	}
+	return TRUE;
+}
+
+// mifare_classic_read_ndef reads the NDEF message of an NDEF formatted tag into message (capacity bytes) and sets length to its length (0: empty message).
+// the MAD tells which sectors hold NDEF data, and only as many blocks of them are read as the message needs: the TLVs are parsed while reading,
+// sector trailers are skipped and MAD2 (4k) is only read if the message goes on past sector 0x0F. a short message costs 2 sectors, not a dump.
+// returns FALSE if the tag holds no NDEF message, or the message is larger than capacity. nothing is printed
+static BOOL do_mifare_classic_read_ndef(BYTE *message, size_t capacity, size_t *length, acr_session *session) {
+	const MifareClassicGeometry *geometry = mifare_classic_geometry_of_tag(acr_session_tag_name(session));
+	if (geometry == NULL) {
+		LOG_WARN("Can not read NDEF: the tag on the reader is no Mifare Classic tag.");
+		return FALSE;
+	}
+
+	BOOL ndefSectors[MIFARE_CLASSIC_MAX_SECTORS] = {0};
+	if (!mifare_classic_read_mad(0x00, ndefSectors, session)) {
+		return FALSE;
+	}
+
+	NdefTlvReader reader;
+	ndef_tlv_reader_init(&reader, message, capacity);
+	BOOL started = FALSE;
+	for (BYTE s = 0x01; (s < geometry->amountSectors) && (reader.status == NDEF_TLV_NEED_MORE); s++) {
+		if (mifare_classic_is_mad_sector(geometry, s)) {
+			if (!mifare_classic_read_mad(s, ndefSectors, session)) {
+				return FALSE;
+			}
+			continue;
+		}
+		if (!ndefSectors[s]) {
+			if (started) {
+				break; // the NDEF sectors follow each other, the message can not go on after a gap
+			}
+			continue;
+		}
+
+		started = TRUE;
+		BYTE firstBlock = mifare_classic_sector_first_block(s);
+		BYTE trailerBlock = mifare_classic_sector_trailer_block(s);
+		if (!mifare_classic_authenticate(firstBlock, s, MIFARE_CLASSIC_KEY_A, KEY_A_NDEF_SECTOR, session)) {
+			return FALSE;
+		}
+		for (BYTE block = firstBlock; (block < trailerBlock) && (reader.status == NDEF_TLV_NEED_MORE); block++) {
+			BYTE data[16];
+			if (!mifare_classic_read_authenticated_block(block, data, session)) {
+				return FALSE;
+			}
+			ndef_tlv_reader_feed(&reader, data, sizeof(data));
+		}
+	}
+
+	switch (reader.status) {
+		case NDEF_TLV_DONE:
+			*length = reader.length;
+			LOG_INFO("Read NDEF message of %zu bytes", reader.length);
+			return TRUE;
+		case NDEF_TLV_NOT_FOUND:
+			LOG_INFO("The tag holds no NDEF message");
+			return FALSE;
+		case NDEF_TLV_NEED_MORE:
+			LOG_ERROR("The NDEF message is cut off, the NDEF sectors end before it does. Aborting..");
+			return FALSE;
+		default:
+			return FALSE; // too long, already logged
+	}
+}
+
+BOOL mifare_classic_read_ndef(BYTE *message, size_t capacity, size_t *length, acr_session *session) {
+	return ACR_SESSION_OPERATION(session, do_mifare_classic_read_ndef(message, capacity, length, session));
+}
+
+// mifare_classic_write_ndef writes message (an NDEF message, e.g. the records of NewNDEF_SR_Text without its TLV header and terminator) onto an NDEF
+// formatted tag: the NDEF message TLV and the terminator TLV go through the sectors that the MAD assigns to NDEF, around the sector trailers.
+// only the blocks the TLVs need are written (the rest of the last block is zeroed), with one authentication per sector. the size is checked against
+// the NDEF sectors before anything is written. MAD2 (4k) is only read if the sectors of MAD1 are too small for the message
+static BOOL do_mifare_classic_write_ndef(const BYTE *message, size_t length, acr_session *session) {
+	const MifareClassicGeometry *geometry = mifare_classic_geometry_of_tag(acr_session_tag_name(session));
+	if (geometry == NULL) {
+		LOG_WARN("Can not write NDEF: the tag on the reader is no Mifare Classic tag.");
+		return FALSE;
+	}
+	if (length > 0xFFFE) {
+		LOG_WARN("An NDEF message can be at most 65534 bytes long, this one has %zu bytes.", length);
+		return FALSE;
+	}
+
+	// NDEF message TLV: 03, the length (one byte, from 255 bytes on FF and two bytes MSB first), the message. then the terminator TLV
+	BYTE header[4] = { TLV_HEADER, (BYTE)length };
+	size_t headerLength = 2;
+	if (length >= 0xFF) {
+		header[1] = TLV_LONG_LENGTH;
+		header[2] = (BYTE)(length >> 8);
+		header[3] = (BYTE)length;
+		headerLength = 4;
+	}
+	size_t tlvLength = headerLength + length + 1;
+
+	// find the NDEF sectors (consecutive, the MAD sector 0x10 in between does not count) until they can hold the TLVs
+	BOOL ndefSectors[MIFARE_CLASSIC_MAX_SECTORS] = {0};
+	if (!mifare_classic_read_mad(0x00, ndefSectors, session)) {
+		return FALSE;
+	}
+	BYTE sectors[MIFARE_CLASSIC_MAX_SECTORS];
+	BYTE amountSectors = 0;
+	size_t capacity = 0;
+	for (BYTE s = 0x01; (s < geometry->amountSectors) && (capacity < tlvLength); s++) {
+		if (mifare_classic_is_mad_sector(geometry, s)) {
+			if (!mifare_classic_read_mad(s, ndefSectors, session)) {
+				return FALSE;
+			}
+			continue;
+		}
+		if (!ndefSectors[s]) {
+			if (amountSectors > 0) {
+				break;
+			}
+			continue;
+		}
+		sectors[amountSectors++] = s;
+		capacity += (size_t)(mifare_classic_sector_block_count(s) - 1) * 16;
+	}
+	if (capacity < tlvLength) {
+		LOG_ERROR("The NDEF message (%zu bytes with its TLVs) does not fit into the NDEF sectors of this tag (%zu bytes). Aborting..", tlvLength, capacity);
+		return FALSE;
+	}
+
+	size_t offset = 0;
+	for (BYTE i = 0; (i < amountSectors) && (offset < tlvLength); i++) {
+		BYTE s = sectors[i];
+		BYTE firstBlock = mifare_classic_sector_first_block(s);
+		BYTE trailerBlock = mifare_classic_sector_trailer_block(s);
+		if (!mifare_classic_authenticate(firstBlock, s, MIFARE_CLASSIC_KEY_A, KEY_A_NDEF_SECTOR, session)) {
+			return FALSE;
+		}
+
+		for (BYTE block = firstBlock; (block < trailerBlock) && (offset < tlvLength); block++) {
+			BYTE data[16] = {0};
+			for (size_t j = 0; (j < 16) && (offset < tlvLength); j++, offset++) {
+				if (offset < headerLength) {
+					data[j] = header[offset];
+				} else if (offset < headerLength + length) {
+					data[j] = message[offset - headerLength];
+				} else {
+					data[j] = TLV_TERMINATOR;
+				}
+			}
+			if (!mifare_classic_write_authenticated_block(block, data, session)) {
+				return FALSE;
+			}
+		}
+	}
+
+	LOG_INFO("Wrote NDEF message of %zu bytes", length);
+	return TRUE;
+}
+
+BOOL mifare_classic_write_ndef(const BYTE *message, size_t length, acr_session *session) {
+	return ACR_SESSION_OPERATION(session, do_mifare_classic_write_ndef(message, length, session));
+}
+
+// -------------------------------- value blocks ---------------------------------
+
+// a value block holds a signed 32 bit value (LSB first) three times (once inverted) and a one byte address four times (twice inverted):
+// value, ~value, value, address, ~address, address, ~address. the tag itself does the arithmetic (increment / decrement + transfer), which is tear-safe
+
+// mifare_classic_value_block_format fills in the 16 bytes of a value block
+void mifare_classic_value_block_format(int32_t value, BYTE address, BYTE *block) {
+	for (int i = 0; i < 4; i++) {
+		block[i] = (BYTE)((uint32_t)value >> (8 * i));
+		block[i + 4] = (BYTE)~block[i];
+		block[i + 8] = block[i];
+	}
+	block[12] = block[14] = address;
+	block[13] = block[15] = (BYTE)~address;
+}
+
+// mifare_classic_value_block_parse returns FALSE if block is no valid value block, address may be NULL
+BOOL mifare_classic_value_block_parse(const BYTE *block, int32_t *value, BYTE *address) {
+	for (int i = 0; i < 4; i++) {
+		if ((block[i] != block[i + 8]) || ((BYTE)(block[i] ^ block[i + 4]) != 0xFF)) {
+			return FALSE;
+		}
+	}
+	if ((block[12] != block[14]) || (block[13] != block[15]) || ((BYTE)(block[12] ^ block[13]) != 0xFF)) {
+		return FALSE;
+	}
+
+	*value = (int32_t)((uint32_t)block[0] | ((uint32_t)block[1] << 8) | ((uint32_t)block[2] << 16) | ((uint32_t)block[3] << 24));
+	if (address != NULL) {
+		*address = block[12];
+	}
+	return TRUE;
+}
+
+// mifare_classic_check_value_block makes sure block can hold a value on this tag (not the manufacturer block, not a sector trailer)
+static BOOL mifare_classic_check_value_block(const MifareClassicGeometry *geometry, BYTE block) {
+	if ((block == 0x00) || (block >= geometry->amountBlocks) || mifare_classic_is_trailer_block(block)) {
+		LOG_WARN("Block 0x%02x of a %s can not be a value block (manufacturer block, sector trailer or out of range).", block, geometry->name);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// mifare_classic_value_block_apdu sends FF D7 (value block operation, page 17 of ACR122U_APIDriverManual.pdf): op 00 store, 01 increment, 02 decrement.
+// the value is sent MSB first. increment and decrement are followed by a transfer into the same block by the reader
+static BOOL mifare_classic_value_block_apdu(BYTE block, BYTE op, int32_t value, acr_session *session) {
+	BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
+	BYTE APDU_Value[10] = { 0xff, 0xd7, 0x00, block, 0x05, op,
+		(BYTE)((uint32_t)value >> 24), (BYTE)((uint32_t)value >> 16), (BYTE)((uint32_t)value >> 8), (BYTE)value };
+	ApduResponse response = executeApdu(session, APDU_Value, sizeof(APDU_Value));
+	if (!isSuccessResponse(response, pbRecvBuffer, 0)) {
+		LOG_ERROR("Value block operation 0x%02x on block 0x%02x failed (is it formatted as value block?). Aborting..", op, block);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// mifare_classic_restore_value_apdu sends FF D7 .. 02 03 target (restore + transfer): copies the value of block into target (both in the authenticated sector)
+static BOOL mifare_classic_restore_value_apdu(BYTE block, BYTE target, acr_session *session) {
+	BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
+	BYTE APDU_Restore[7] = { 0xff, 0xd7, 0x00, block, 0x02, 0x03, target };
+	ApduResponse response = executeApdu(session, APDU_Restore, sizeof(APDU_Restore));
+	if (!isSuccessResponse(response, pbRecvBuffer, 0)) {
+		LOG_ERROR("Failed to copy the value of block 0x%02x to block 0x%02x. Aborting..", block, target);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// mifare_classic_read_value reads a value block with FF B1 (the reader checks the value block format and returns the value MSB first)
+static BOOL do_mifare_classic_read_value(const MifareClassicGeometry *geometry, BYTE block, BYTE keyType, const BYTE *key, int32_t *value, acr_session *session) {
+	BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
+	if (!mifare_classic_check_value_block(geometry, block) ||
+		!mifare_classic_authenticate(block, mifare_classic_sector_of_block(block), keyType, key, session)) {
+		return FALSE;
+	}
+
+	BYTE APDU_ReadValue[5] = { 0xff, 0xb1, 0x00, block, 0x04 };
+	ApduResponse response = executeApdu(session, APDU_ReadValue, sizeof(APDU_ReadValue));
+	if (!isSuccessResponse(response, pbRecvBuffer, 4)) {
+		LOG_ERROR("Failed to read the value of block 0x%02x (is it formatted as value block?). Aborting..", block);
+		return FALSE;
+	}
+	*value = (int32_t)(((uint32_t)pbRecvBuffer[0] << 24) | ((uint32_t)pbRecvBuffer[1] << 16) | ((uint32_t)pbRecvBuffer[2] << 8) | (uint32_t)pbRecvBuffer[3]);
+	return TRUE;
+}
+
+BOOL mifare_classic_read_value(const MifareClassicGeometry *geometry, BYTE block, BYTE keyType, const BYTE *key, int32_t *value, acr_session *session) {
+	return ACR_SESSION_OPERATION(session, do_mifare_classic_read_value(geometry, block, keyType, key, value, session));
+}
+
+// mifare_classic_store_value formats block as value block holding value (the address byte is set to the block number)
+static BOOL do_mifare_classic_store_value(const MifareClassicGeometry *geometry, BYTE block, BYTE keyType, const BYTE *key, int32_t value, acr_session *session) {
+	if (!mifare_classic_check_value_block(geometry, block) ||
+		!mifare_classic_authenticate(block, mifare_classic_sector_of_block(block), keyType, key, session)) {
+		return FALSE;
+	}
+	return mifare_classic_value_block_apdu(block, 0x00, value, session);
+}
+
+BOOL mifare_classic_store_value(const MifareClassicGeometry *geometry, BYTE block, BYTE keyType, const BYTE *key, int32_t value, acr_session *session) {
+	return ACR_SESSION_OPERATION(session, do_mifare_classic_store_value(geometry, block, keyType, key, value, session));
+}
+
+// mifare_classic_restore_value copies the value block source into target, both have to be in the same sector
+static BOOL do_mifare_classic_restore_value(const MifareClassicGeometry *geometry, BYTE source, BYTE target, BYTE keyType, const BYTE *key, acr_session *session) {
+	if (!mifare_classic_check_value_block(geometry, source) || !mifare_classic_check_value_block(geometry, target)) {
+		return FALSE;
+	}
+	BYTE sector = mifare_classic_sector_of_block(source);
+	if (sector != mifare_classic_sector_of_block(target)) {
+		LOG_WARN("Blocks 0x%02x and 0x%02x are not in the same sector, a value can only be restored within a sector.", source, target);
+		return FALSE;
+	}
+	if (!mifare_classic_authenticate(source, sector, keyType, key, session)) {
+		return FALSE;
+	}
+	return mifare_classic_restore_value_apdu(source, target, session);
+}
+
+BOOL mifare_classic_restore_value(const MifareClassicGeometry *geometry, BYTE source, BYTE target, BYTE keyType, const BYTE *key, acr_session *session) {
+	return ACR_SESSION_OPERATION(session, do_mifare_classic_restore_value(geometry, source, target, keyType, key, session));
+}
+
+// mifare_classic_adjust_value adds delta (negative: subtracts) to the value block in a single exchange (increment / decrement + transfer),
+// plus the authentication unless the sector already is authenticated with key. backupBlock (0x00: none) receives a copy of the new value
+// (one more exchange, same sector only). newValue (may be NULL) reads the result back (one more exchange)
+static BOOL do_mifare_classic_adjust_value(const MifareClassicGeometry *geometry, BYTE block, BYTE keyType, const BYTE *key, int32_t delta, BYTE backupBlock, int32_t *newValue, acr_session *session) {
+	BYTE sector = mifare_classic_sector_of_block(block);
+	if (!mifare_classic_check_value_block(geometry, block)) {
+		return FALSE;
+	}
+	if ((backupBlock != 0x00) && (!mifare_classic_check_value_block(geometry, backupBlock) || (mifare_classic_sector_of_block(backupBlock) != sector))) {
+		LOG_WARN("Backup block 0x%02x has to be a data block in the same sector as block 0x%02x.", backupBlock, block);
+		return FALSE;
+	}
+	if (delta == INT32_MIN) {
+		LOG_WARN("Can not adjust a value by %ld, the tag only takes magnitudes up to %ld.", (long)delta, (long)INT32_MAX);
+		return FALSE;
+	}
+
+	if (!mifare_classic_authenticate(block, sector, keyType, key, session)) {
+		return FALSE;
+	}
+	if ((delta != 0) && !mifare_classic_value_block_apdu(block, (delta > 0) ? 0x01 : 0x02, (delta > 0) ? delta : -delta, session)) {
+		return FALSE;
+	}
+	if ((backupBlock != 0x00) && !mifare_classic_restore_value_apdu(block, backupBlock, session)) {
+		return FALSE;
+	}
+	if (newValue != NULL) {
+		return do_mifare_classic_read_value(geometry, block, keyType, key, newValue, session);
+	}
+
+	return TRUE;
+}
+
+BOOL mifare_classic_adjust_value(const MifareClassicGeometry *geometry, BYTE block, BYTE keyType, const BYTE *key, int32_t delta, BYTE backupBlock, int32_t *newValue, acr_session *session) {
+	return ACR_SESSION_OPERATION(session, do_mifare_classic_adjust_value(geometry, block, keyType, key, delta, backupBlock, newValue, session));
+}
@@ -0,0 +1,169 @@
+#ifndef MIFARE_CLASSIC_H
+#define MIFARE_CLASSIC_H
+
+#ifndef MAIN_H
+#include "main.h"
+#endif
+
+#ifndef COMMON_H
+#include "common.h"
+#endif
+
+#ifndef LOGGING_C
+#include "logging.c"
+#endif
+
+// One driver for Mifare Mini, Classic 1k and Classic 4k. All of them share the same block layout, the smaller tags simply end earlier:
+// sectors 0x00 - 0x1F have 4 blocks (3 data blocks + sector trailer), sectors 0x20 - 0x27 (4k only) have 16 blocks (15 data blocks + sector trailer).
+// Functions that depend on the size of the tag take a MifareClassicGeometry (MIFARE_CLASSIC_GEOMETRY_MINI / _1K / _4K).
+
+// key types of the authenticate APDU (FF 86)
+#define MIFARE_CLASSIC_KEY_A 0x60
+#define MIFARE_CLASSIC_KEY_B 0x61
+
+#define MIFARE_CLASSIC_MINI_SIZE 320
+#define MIFARE_CLASSIC_1K_SIZE 1024
+#define MIFARE_CLASSIC_4K_SIZE 4096
+#define MIFARE_CLASSIC_MAX_SECTORS 40
+#define MIFARE_CLASSIC_MAX_DATA_BLOCKS 15   // data blocks of a 16 block sector
+
+// MifareClassicGeometry describes the size of a tag type
+typedef struct MifareClassicGeometry {
+    const char *name;       // as determined by getStatus (see acr_session_tag_name)
+    BYTE amountSectors;     // 5 (Mini), 16 (1k) or 40 (4k)
+    uint16_t amountBlocks;  // 20, 64 or 256 (sector trailers included)
+    uint32_t size;          // 320, 1024 or 4096 bytes
+} MifareClassicGeometry;
+
+extern const MifareClassicGeometry MIFARE_CLASSIC_GEOMETRY_MINI;
+extern const MifareClassicGeometry MIFARE_CLASSIC_GEOMETRY_1K;
+extern const MifareClassicGeometry MIFARE_CLASSIC_GEOMETRY_4K;
+
+// SectorContent is a struct that holds the sectorID (0x00, 0x01, etc.), the content of the data blocks in the sector (3, or 15 in sectors 0x20 - 0x27)
+// and a status bool (success /failure)
+typedef struct SectorContent {
+    BYTE sectorID;
+    BYTE amountBlocks;                                  // data blocks in blocks
+    BYTE blocks[MIFARE_CLASSIC_MAX_DATA_BLOCKS][16];    // each of which holds 16 bytes
+    LONG status;
+} SectorContent;
+
+// MifareClassicKey is a key together with the slot it is meant for (key A or key B of a sector trailer)
+typedef struct MifareClassicKey {
+    BYTE keyType;       // MIFARE_CLASSIC_KEY_A or MIFARE_CLASSIC_KEY_B
+    BYTE key[6];
+} MifareClassicKey;
+
+// MifareClassicKeyset is a list of keys that are tried one after another until one of them authenticates a sector
+typedef struct MifareClassicKeyset {
+    const MifareClassicKey *keys;
+    size_t amountKeys;
+} MifareClassicKeyset;
+
+// MifareClassicImage is the content of an entire tag: block n is at data + n * 16 (sector trailers included, with the key that read the sector put in,
+// so a sector read with key B has an unknown key A: all zeroes, as returned by the tag)
+typedef struct MifareClassicImage {
+    BYTE data[MIFARE_CLASSIC_4K_SIZE];
+    uint32_t size;                                          // 320, 1024 or 4096 bytes
+    BYTE amountSectors;                                     // 5, 16 or 40
+    uint64_t sectorsRead;                                   // bit n: sector n was read (see mifare_classic_image_sector_ok)
+    MifareClassicKey sectorKeys[MIFARE_CLASSIC_MAX_SECTORS]; // key that authenticated sector n
+} MifareClassicImage;
+
+// MifareClassicSectorCallback is called by mifare_classic_dump after every sector (success: sector is in the image)
+typedef void (*MifareClassicSectorCallback)(const MifareClassicImage *image, BYTE sector, BOOL success, void *arg);
+
+// MifareClassicKeySource authenticates sector with a key of its choice and tells which one it was (FALSE: no key works)
+typedef BOOL (*MifareClassicKeySource)(void *ctx, BYTE sector, MifareClassicKey *key, acr_session *session);
+
+// operations whose permission is encoded in the access bits (C1 C2 C3 per block group) of a sector trailer
+typedef enum MifareClassicAccessOp {
+    MIFARE_CLASSIC_ACCESS_READ,                 // data block: read, sector trailer: read the access bits
+    MIFARE_CLASSIC_ACCESS_WRITE,                // data block: write, sector trailer: write all of it (key A, access bits and key B)
+    MIFARE_CLASSIC_ACCESS_INCREMENT,            // value blocks only
+    MIFARE_CLASSIC_ACCESS_DECREMENT,            // value blocks only (decrement, transfer and restore)
+    MIFARE_CLASSIC_ACCESS_WRITE_KEY_A,          // sector trailers only
+    MIFARE_CLASSIC_ACCESS_WRITE_ACCESS_BITS,    // sector trailers only
+    MIFARE_CLASSIC_ACCESS_READ_KEY_B,           // sector trailers only
+    MIFARE_CLASSIC_ACCESS_WRITE_KEY_B           // sector trailers only
+} MifareClassicAccessOp;
+
+// bits of the key mask returned by mifare_classic_access_keys
+#define MIFARE_CLASSIC_ACCESS_KEY_A 0x01
+#define MIFARE_CLASSIC_ACCESS_KEY_B 0x02
+
+// index of the sector trailer in the conditions of mifare_classic_access_bits_decode (0 - 2 are the data block groups)
+#define MIFARE_CLASSIC_ACCESS_GROUP_TRAILER 3
+
+extern const MifareClassicKeyset MIFARE_CLASSIC_DEFAULT_KEYSET;
+
+// geometry
+const MifareClassicGeometry *mifare_classic_geometry_of_tag(const char *tagName);
+const MifareClassicGeometry *mifare_classic_geometry_of_size(uint32_t size);
+BYTE mifare_classic_sector_first_block(BYTE sector);
+BYTE mifare_classic_sector_block_count(BYTE sector);
+BYTE mifare_classic_sector_trailer_block(BYTE sector);
+BYTE mifare_classic_sector_of_block(BYTE block);
+BOOL mifare_classic_is_trailer_block(BYTE block);
+BOOL mifare_classic_is_mad_sector(const MifareClassicGeometry *geometry, BYTE sector);
+BYTE mifare_classic_mad_crc(const BYTE *data, size_t length);
+
+// access bits (bytes 6 - 8 of a sector trailer, byte 9 is general purpose)
+BOOL mifare_classic_access_bits_decode(const BYTE *accessBits, BYTE *conditions);
+void mifare_classic_access_bits_encode(const BYTE *conditions, BYTE *accessBits);
+BYTE mifare_classic_access_keys(const BYTE *conditions, BYTE block, MifareClassicAccessOp op);
+BYTE mifare_classic_access_key_type(const BYTE *accessBits, BYTE block, MifareClassicAccessOp op, BYTE preferred);
+BOOL mifare_classic_check_trailer(const BYTE *trailer, BOOL allowIrreversible);
+
+// building blocks (the caller is responsible for acr_session_begin_operation, if wanted)
+BOOL mifare_classic_authenticate(BYTE block, int sector, BYTE keyType, const BYTE *key, acr_session *session);
+BOOL mifare_classic_try_key(BYTE block, int sector, BYTE keyType, const BYTE *key, acr_session *session);
+BOOL mifare_classic_write_authenticated_block(BYTE block, const BYTE *data, acr_session *session);
+BOOL mifare_classic_read_sector_blocks(BYTE sector, BYTE keyType, const BYTE *key, BYTE *blocks, acr_session *session);
+BOOL mifare_classic_write_sector(BYTE sector, BYTE keyType, const BYTE *key, const BYTE *blocks, const BYTE *trailer, acr_session *session);
+
+// whole tag
+BOOL mifare_classic_keyset_source(void *ctx, BYTE sector, MifareClassicKey *key, acr_session *session);
+BOOL mifare_classic_dump(const MifareClassicKeyset *keyset, MifareClassicImage *image, MifareClassicSectorCallback sectorDone, void *arg, acr_session *session);
+BOOL mifare_classic_dump_with(MifareClassicKeySource source, void *ctx, MifareClassicImage *image, MifareClassicSectorCallback sectorDone, void *arg, acr_session *session);
+BOOL mifare_classic_image_sector_ok(const MifareClassicImage *image, BYTE sector);
+BOOL mifare_classic_write_image(const MifareClassicKeyset *keyset, const MifareClassicImage *target, MifareClassicImage *current, acr_session *session);
+
+SectorContent mifare_classic_read_sector(const MifareClassicGeometry *geometry, BYTE sector, const BYTE *keyA, acr_session *session);
+// consecutive mifare_classic_write_block calls only share their authentication if the caller wraps them in one operation
+// (acr_session_begin_operation / acr_session_end_operation), otherwise each of them loads the key and authenticates again
+BOOL mifare_classic_write_block(const MifareClassicGeometry *geometry, const BYTE *BlockData, BYTE block, const BYTE *keyA, acr_session *session);
+BOOL mifare_classic_reset_card(const MifareClassicGeometry *geometry, const BYTE *keyA, acr_session *session);
+BOOL mifare_classic_ndef_to_uninitialized(const MifareClassicGeometry *geometry, acr_session *session);
+BOOL mifare_classic_uninitialized_to_ndef(const MifareClassicGeometry *geometry, acr_session *session);
+BOOL mifare_classic_read_ndef(BYTE *message, size_t capacity, size_t *length, acr_session *session);
+BOOL mifare_classic_write_ndef(const BYTE *message, size_t length, acr_session *session);
+
+// value blocks (the tag does the arithmetic, see mifare_classic_adjust_value)
+void mifare_classic_value_block_format(int32_t value, BYTE address, BYTE *block);
+BOOL mifare_classic_value_block_parse(const BYTE *block, int32_t *value, BYTE *address);
+BOOL mifare_classic_read_value(const MifareClassicGeometry *geometry, BYTE block, BYTE keyType, const BYTE *key, int32_t *value, acr_session *session);
+BOOL mifare_classic_store_value(const MifareClassicGeometry *geometry, BYTE block, BYTE keyType, const BYTE *key, int32_t value, acr_session *session);
+BOOL mifare_classic_restore_value(const MifareClassicGeometry *geometry, BYTE source, BYTE target, BYTE keyType, const BYTE *key, acr_session *session);
+BOOL mifare_classic_adjust_value(const MifareClassicGeometry *geometry, BYTE block, BYTE keyType, const BYTE *key, int32_t delta, BYTE backupBlock, int32_t *newValue, acr_session *session);
+
+extern const BYTE NDEF_MAD_SECTOR_TRAILER[16];
+extern const BYTE NDEF_SECTOR_TRAILER[16];
+
+extern const BYTE UNINITIALIZED_SECTOR_TRAILER[16];
+
+extern const BYTE KEY_A_DEFAULT[6];
+extern const BYTE KEY_B_DEFAULT[6];
+
+extern const BYTE KEY_A_NDEF_MAD_SECTOR[6];
+extern const BYTE KEY_B_NDEF_MAD_SECTOR[6];
+extern const BYTE KEY_A_NDEF_SECTOR[6];
+extern const BYTE KEY_B_NDEF_SECTOR[6];
+
+extern const BYTE ACCESS_BITS_UNINITIALIZED[4];
+extern const BYTE ACCESS_BITS_NDEF_MAD_SECTOR[4];
+extern const BYTE ACCESS_BITS_NDEF_SECTOR[4];
+
+extern const BYTE NDEF_EMPTY_MESSAGE_BLOCK[16];
+
+#endif
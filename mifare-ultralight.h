@@ -13,14 +13,18 @@
 #include "logging.c"
 #endif
 
-extern const BYTE ULTRALIGHT_1x_USER_MEMORY[12];
-extern const BYTE ULTRALIGHT_1x_EXISTING_PAGES[20];
+#ifndef TYPE2_TAG_H
+#include "type2-tag.h"
+#endif
+
+// the original Mifare Ultralight EV1 (MF0UL11) functions, now thin wrappers around the Type 2 driver, plus the counters only the EV1 has.
+// everything else: the type2_ functions (type2-tag.h) with TYPE2_MODEL_ULTRALIGHT_EV1
 
-BOOL ultralight_read_page(BYTE page, SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
-BOOL ultralight_fast_read(SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
-BOOL ultralight_write_page(BYTE* data, BYTE page, SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
-BOOL ultralight_reset_user_data(SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
-BOOL ultralight_read_counter(BYTE counter, SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
-BOOL ultralight_increment_counter(BYTE counter, SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
+BOOL ultralight_read_page(BYTE page, acr_session *session);
+BOOL ultralight_fast_read(acr_session *session);
+BOOL ultralight_write_page(BYTE* data, BYTE page, acr_session *session);
+BOOL ultralight_reset_user_data(acr_session *session);
+BOOL ultralight_read_counter(BYTE counter, acr_session *session);
+BOOL ultralight_increment_counter(BYTE counter, acr_session *session);
 
 #endif
@@ -50,3 +50,107 @@ BYTE* NewNDEF_SR_Text(const BYTE* text, BYTE text_len, size_t* out_total_size) {
 
     return buffer;
 }
+
+
+// states of NdefTlvReader
+enum {
+    NDEF_TLV_STATE_TYPE,
+    NDEF_TLV_STATE_LENGTH,
+    NDEF_TLV_STATE_LONG_LENGTH_MSB,
+    NDEF_TLV_STATE_LONG_LENGTH_LSB,
+    NDEF_TLV_STATE_VALUE,
+    NDEF_TLV_STATE_END
+};
+
+void ndef_tlv_reader_init(NdefTlvReader *reader, BYTE *message, size_t capacity) {
+    memset(reader, 0, sizeof(*reader));
+    reader->message = message;
+    reader->capacity = capacity;
+    reader->state = NDEF_TLV_STATE_TYPE;
+    reader->status = NDEF_TLV_NEED_MORE;
+}
+
+// ndef_tlv_reader_value_starts is called once the length of the current TLV is known
+static void ndef_tlv_reader_value_starts(NdefTlvReader *reader) {
+    reader->received = 0;
+    if (reader->type != TLV_HEADER) {
+        reader->state = (reader->length == 0) ? NDEF_TLV_STATE_TYPE : NDEF_TLV_STATE_VALUE;
+        return;
+    }
+
+    if (reader->length > reader->capacity) {
+        LOG_WARN("The NDEF message is %zu bytes long, but there is only room for %zu bytes", reader->length, reader->capacity);
+        reader->status = NDEF_TLV_TOO_LONG;
+        reader->state = NDEF_TLV_STATE_END;
+    } else if (reader->length == 0) {
+        reader->status = NDEF_TLV_DONE; // empty NDEF message
+        reader->state = NDEF_TLV_STATE_END;
+    } else {
+        reader->state = NDEF_TLV_STATE_VALUE;
+    }
+}
+
+// ndef_tlv_reader_feed parses the next length bytes of tag memory. once it returns anything but NDEF_TLV_NEED_MORE, the rest of the tag is of no interest
+NdefTlvStatus ndef_tlv_reader_feed(NdefTlvReader *reader, const BYTE *data, size_t length) {
+    for (size_t i = 0; (i < length) && (reader->state != NDEF_TLV_STATE_END); i++) {
+        BYTE b = data[i];
+        switch (reader->state) {
+            case NDEF_TLV_STATE_TYPE:
+                if (b == TLV_NULL) {
+                    break;
+                }
+                if (b == TLV_TERMINATOR) {
+                    reader->status = NDEF_TLV_NOT_FOUND;
+                    reader->state = NDEF_TLV_STATE_END;
+                    break;
+                }
+                reader->type = b;
+                reader->state = NDEF_TLV_STATE_LENGTH;
+                break;
+
+            case NDEF_TLV_STATE_LENGTH:
+                if (b == TLV_LONG_LENGTH) {
+                    reader->state = NDEF_TLV_STATE_LONG_LENGTH_MSB;
+                    break;
+                }
+                reader->length = b;
+                ndef_tlv_reader_value_starts(reader);
+                break;
+
+            case NDEF_TLV_STATE_LONG_LENGTH_MSB:
+                reader->length = (size_t)b << 8;
+                reader->state = NDEF_TLV_STATE_LONG_LENGTH_LSB;
+                break;
+
+            case NDEF_TLV_STATE_LONG_LENGTH_LSB:
+                reader->length |= b;
+                ndef_tlv_reader_value_starts(reader);
+                break;
+
+            case NDEF_TLV_STATE_VALUE: {
+                // take as much of the value as this piece holds at once
+                size_t take = length - i;
+                if (take > reader->length - reader->received) {
+                    take = reader->length - reader->received;
+                }
+                if (reader->type == TLV_HEADER) {
+                    memcpy(reader->message + reader->received, data + i, take);
+                }
+                reader->received += take;
+                i += take - 1;
+
+                if (reader->received == reader->length) {
+                    if (reader->type == TLV_HEADER) {
+                        reader->status = NDEF_TLV_DONE;
+                        reader->state = NDEF_TLV_STATE_END;
+                    } else {
+                        reader->state = NDEF_TLV_STATE_TYPE;
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    return reader->status;
+}
@@ -49,6 +49,9 @@
 #define STATUS          0x02
 #define LANG_CODE_EN    { 0x65, 0x6E }  // "en"
 #define TLV_TERMINATOR  0xFE
+#define TLV_NULL        0x00            // padding, has no length byte
+#define TLV_PROPRIETARY 0xFD
+#define TLV_LONG_LENGTH 0xFF            // length byte that announces a 2 byte length (MSB first), for values of 255 bytes and more
 
 typedef struct NDEF_SR_Text {
     BYTE tlv_header;        // constant
@@ -74,9 +77,31 @@ typedef struct NDEF_SR_Text {
 // } NDEFShortRecord;
 
 
+// NdefTlvReader finds the first NDEF message TLV in tag memory that is fed to it piece by piece (e.g. block by block), so that the caller can stop
+// reading the tag as soon as the message is complete. other TLVs (lock control, memory control, proprietary, NULL padding) are skipped
+typedef enum NdefTlvStatus {
+    NDEF_TLV_NEED_MORE,     // feed the next bytes
+    NDEF_TLV_DONE,          // message holds the entire NDEF message (length bytes)
+    NDEF_TLV_NOT_FOUND,     // terminator TLV before an NDEF message TLV
+    NDEF_TLV_TOO_LONG       // the NDEF message does not fit into message
+} NdefTlvStatus;
+
+typedef struct NdefTlvReader {
+    BYTE *message;
+    size_t capacity;
+    size_t length;          // length of the NDEF message (valid once the length bytes were fed)
+    size_t received;        // bytes of the current TLV value that were fed so far
+    BYTE type;              // type of the current TLV
+    BYTE state;
+    NdefTlvStatus status;
+} NdefTlvReader;
+
 // methods
 BYTE* NewNDEF_SR_Text(const BYTE* text, BYTE text_len, size_t* out_total_size);
 
+void ndef_tlv_reader_init(NdefTlvReader *reader, BYTE *message, size_t capacity);
+NdefTlvStatus ndef_tlv_reader_feed(NdefTlvReader *reader, const BYTE *data, size_t length);
+
 
 
 #endif
\ No newline at end of file
@@ -13,19 +13,16 @@
 #include "logging.c"
 #endif
 
-typedef struct NTAG_213_Pages {
-    BYTE Pages[45][4]; // 45 pages (0x00 - 0x2C) with 4 bytes per page
-} NTAG_213_Pages;
-
-extern const BYTE NTAG_213_USER_MEMORY_PAGES[36];
-extern const BYTE NTAG_213_EXISTING_PAGES[45];
+#ifndef TYPE2_TAG_H
+#include "type2-tag.h"
+#endif
 
-void ntag_213_pages_object_print_all(BYTE from_page, BYTE to_page, NTAG_213_Pages *tag_content);
+// the original NTAG 213 functions, now thin wrappers around the Type 2 driver. everything else: the type2_ functions (type2-tag.h) with TYPE2_MODEL_NTAG_213
 
 // functions
-BOOL ntag_213_write_page(BYTE* data, BYTE page, SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
-BOOL ntag_213_reset_user_data(SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
-BOOL ntag_213_fast_read(BYTE from_page, BYTE to_page, SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
+BOOL ntag_213_write_page(BYTE* data, BYTE page, acr_session *session);
+BOOL ntag_213_reset_user_data(acr_session *session);
+BOOL ntag_213_fast_read(BYTE from_page, BYTE to_page, acr_session *session);
 
 
 #endif
@@ -13,19 +13,16 @@
 #include "logging.c"
 #endif
 
-typedef struct NTAG_215_Pages {
-    BYTE Pages[135][4]; // 135 pages (0x00 - 0x86) with 4 bytes per page
-} NTAG_215_Pages;
-
-extern const BYTE NTAG_215_USER_MEMORY_PAGES[126];
-extern const BYTE NTAG_215_EXISTING_PAGES[135];
+#ifndef TYPE2_TAG_H
+#include "type2-tag.h"
+#endif
 
-void ntag_215_pages_object_print_all(BYTE from_page, BYTE to_page, NTAG_215_Pages *tag_content);
+// the original NTAG 215 functions, now thin wrappers around the Type 2 driver. everything else: the type2_ functions (type2-tag.h) with TYPE2_MODEL_NTAG_215
 
 // functions
-BOOL ntag_215_write_page(BYTE* data, BYTE page, SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
-BOOL ntag_215_reset_user_data(SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
-BOOL ntag_215_fast_read(BYTE from_page, BYTE to_page, SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
+BOOL ntag_215_write_page(BYTE* data, BYTE page, acr_session *session);
+BOOL ntag_215_reset_user_data(acr_session *session);
+BOOL ntag_215_fast_read(BYTE from_page, BYTE to_page, acr_session *session);
 
 
 #endif
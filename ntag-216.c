@@ -1,162 +1,20 @@
 #include "ntag-216.h"
 #include "logging.c"
 #include "main.h"
+#include "type2-tag.h"
 
-// each page holds 4 bytes
-const BYTE NTAG_216_USER_MEMORY_PAGES[222] = {                         0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
-                                               0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,
-                                               0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 
-                                               0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 
-                                               0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F, 
-                                               0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F, 
-                                               0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F, 
-                                               0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F, 
-                                               0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x8D, 0x8E, 0x8F, 
-                                               0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0x9B, 0x9C, 0x9D, 0x9E, 0x9F, 
-                                               0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF, 
-                                               0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE, 0xBF, 
-                                               0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF, 
-                                               0xD0, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF, 
-                                               0xE0, 0xE1 };
-
-const BYTE NTAG_216_EXISTING_PAGES[231] =    { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
-                                               0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,
-                                               0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
-                                               0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 
-                                               0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F, 
-                                               0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F, 
-                                               0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F, 
-                                               0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F, 
-                                               0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x8D, 0x8E, 0x8F, 
-                                               0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0x9B, 0x9C, 0x9D, 0x9E, 0x9F, 
-                                               0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF, 
-                                               0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE, 0xBF, 
-                                               0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF, 
-                                               0xD0, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF, 
-                                               0xE0, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6 };
-
-#define MAX_PAGES_PER_READ 50 // guarantees that max of 5 fastReads are required to read entire tag with acr122u limitation
-
-// ---------------- write / read tag --------------------------------------------------
-
-// ntag_216_write_page writes 4 bytes to a page
-BOOL ntag_216_write_page(BYTE* data, BYTE page, SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize) {
-    LOG_DEBUG("Trying to write to page 0x%02x.", page);
-    // sanity check
-    if (!is_byte_in_array(page, NTAG_216_USER_MEMORY_PAGES, 222)) {
-        LOG_WARN("Page 0x%02x is not a user memory page. Refusing to write there.", page);
-        return FALSE;
-    }
-
-    // ff 00 00 00 08 (communicate with pn532 and 8 byte (4 byte command and 4 byte data) command will follow)
-    //      d4 (data exchange command)
-    //      42 (InCommunicateThru)
-    //      a2 (Write) [page 41 of ntag21x document]
-    //      page (which page you target)
-    //      4 bytes you want to write
-    BYTE APDU_Write[9 + 4] = { 0xff, 0x00, 0x00, 0x00, 0x08, 0xd4, 0x42, 0xa2, page };
-    memcpy(APDU_Write + 9, data, 4);
-
-    // write to page
-    ApduResponse response = executeApdu(hCard, APDU_Write, sizeof(APDU_Write), pbRecvBuffer, pbRecvBufferSize);
-    if (response.status != 0 || !(pbRecvBuffer[3] == 0x90 && pbRecvBuffer[4] == 0x00)) {
-        LOG_ERROR("Failed to write to page 0x%02x. Aborting..", page);
-        return FALSE;
-    }
-    LOG_INFO("Wrote data to page 0x%02x with success.", page);
-
-    return TRUE;
+// ntag_216_write_page writes 4 bytes to a page of user memory
+BOOL ntag_216_write_page(BYTE* data, BYTE page, acr_session *session) {
+    return type2_write_page(&TYPE2_MODEL_NTAG_216, data, page, session);
 }
 
-// ntag_216_reset_user_data writes zeroes to pages 0x04 - 0x81
-BOOL ntag_216_reset_user_data(SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize) {
-    LOG_DEBUG("Trying to reset all user data pages to zeroes.");
-    BYTE Zeroes[4] = {0};
-    for (int i=0; i<222; ++i) {
-        BOOL success = ntag_216_write_page(Zeroes, NTAG_216_USER_MEMORY_PAGES[i], hCard, pbRecvBuffer, pbRecvBufferSize);
-        if (!success) {
-            LOG_ERROR("An error occurred, aborting..");
-            return FALSE;
-        }
-    }
-
-    return TRUE;
+// ntag_216_reset_user_data writes zeroes to all user memory pages
+BOOL ntag_216_reset_user_data(acr_session *session) {
+    return type2_reset_user_data(&TYPE2_MODEL_NTAG_216, session);
 }
 
-// ntag_216_fast_read reads all data between 'from_page' and 'to_page'
-BOOL ntag_216_fast_read(BYTE from_page, BYTE to_page, SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize) {
-    LOG_DEBUG("Trying to fast read from page 0x%02x to page 0x%02x.", from_page, to_page);
-    // sanity checks
-    //      both pages are in valid range
-    if (!is_byte_in_array(from_page, NTAG_216_EXISTING_PAGES, 231)) {
-        LOG_WARN("from_page 0x%02x you provided is not valid! Must be in [0x00, 0x86]", from_page);
-        return FALSE;
-    }
-    if (!is_byte_in_array(to_page, NTAG_216_EXISTING_PAGES, 231)) {
-        LOG_WARN("to_page 0x%02x you provided is not valid! Must be in [0x00, 0x86]", to_page);
-        return FALSE;
-    }
-    //      swap the two pages if necessary
-    if (from_page > to_page) {
-        BYTE tmp = to_page;
-        to_page = from_page;
-        from_page = tmp;
-        LOG_DEBUG("Swapped from_page and to_page");
-    }
-
-
-    // Main problem: Fast reading entire tag with 256 Bytes buffer is NOT possible at once cuz 231*4 + 3 ("d5 43 00") + 2 ("90 00") = 929 > 256,
-    //               it is a limitation of pn532 (reader inside of acr122u), so we might have to split the fast read into 5 parts (depends on how many pages user wants to read)
-   
-    // store page data
-    NTAG_216_Pages tag_content = {0};
-
-    BYTE current_page = from_page;
-    while (current_page <= to_page) {
-        BYTE read_start = current_page;
-        BYTE remaining_pages = to_page - current_page + 1;
-        BYTE pages_to_read = (remaining_pages > MAX_PAGES_PER_READ) ? MAX_PAGES_PER_READ : remaining_pages; // read at most 50 pages at once
-        BYTE read_end = current_page + pages_to_read - 1;
-
-        // ff 00 00 00 05 (communicate with pn532 and 05 byte command will follow)
-        //      d4 (data exchange command)
-        //      42 (InCommunicateThru)
-        //      3a (FastRead) [page 39 of ntag21x document]
-        //      read from page
-        //      read to page
-        // Response:
-        //      d5 43 00 
-        //      all bytes read
-        //      90 00
-        BYTE APDU_Read[10] = { 0xff, 0x00, 0x00, 0x00, 0x05, 0xd4, 0x42, 0x3a, read_start, read_end };
-        ApduResponse response = executeApdu(hCard, APDU_Read, sizeof(APDU_Read), pbRecvBuffer, pbRecvBufferSize);
-        if (response.status != 0 || !(pbRecvBuffer[3 + pages_to_read * 4] == 0x90 && pbRecvBuffer[3 + pages_to_read * 4 + 1] == 0x00)) {
-            LOG_ERROR("Fast read from page 0x%02x to 0x%02x failed.", read_start, read_end);
-            return FALSE;
-        }
-
-        // copy into object tag_content
-        BYTE* pages_data_start = pbRecvBuffer + 3;
-        for (int i = 0; i < pages_to_read; ++i) {
-            memcpy(tag_content.Pages[read_start + i], pages_data_start + i * 4, 4);
-        }
-
-        current_page += pages_to_read;
-    }
-
-    // print only the read pages in human-readable form (as in nicely formatted hex)
-    ntag_216_pages_object_print_all(from_page, to_page, &tag_content);
-
-    return TRUE;
+// ntag_216_fast_read reads all data between 'from_page' and 'to_page' and prints it
+BOOL ntag_216_fast_read(BYTE from_page, BYTE to_page, acr_session *session) {
+    return type2_fast_read(&TYPE2_MODEL_NTAG_216, from_page, to_page, session);
 }
 
-void ntag_216_pages_object_print_all(BYTE from_page, BYTE to_page, NTAG_216_Pages *tag_content) {
-    for (BYTE i = from_page; i <= to_page; ++i) {
-        printf("[Page 0x%02X]\t0x%02X  0x%02X  0x%02X  0x%02X\n",
-           i,
-           tag_content->Pages[i][0],
-           tag_content->Pages[i][1],
-           tag_content->Pages[i][2],
-           tag_content->Pages[i][3]);
-    }
-}
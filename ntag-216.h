@@ -13,19 +13,16 @@
 #include "logging.c"
 #endif
 
-typedef struct NTAG_216_Pages {
-    BYTE Pages[231][4]; // 231 pages (0x00 - 0xE6) with 4 bytes per page
-} NTAG_216_Pages;
-
-extern const BYTE NTAG_216_USER_MEMORY_PAGES[222];
-extern const BYTE NTAG_216_EXISTING_PAGES[231];
+#ifndef TYPE2_TAG_H
+#include "type2-tag.h"
+#endif
 
-void ntag_216_pages_object_print_all(BYTE from_page, BYTE to_page, NTAG_216_Pages *tag_content);
+// the original NTAG 216 functions, now thin wrappers around the Type 2 driver. everything else: the type2_ functions (type2-tag.h) with TYPE2_MODEL_NTAG_216
 
 // functions
-BOOL ntag_216_write_page(BYTE* data, BYTE page, SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
-BOOL ntag_216_reset_user_data(SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
-BOOL ntag_216_fast_read(BYTE from_page, BYTE to_page, SCARDHANDLE hCard, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
+BOOL ntag_216_write_page(BYTE* data, BYTE page, acr_session *session);
+BOOL ntag_216_reset_user_data(acr_session *session);
+BOOL ntag_216_fast_read(BYTE from_page, BYTE to_page, acr_session *session);
 
 
 #endif
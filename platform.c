@@ -0,0 +1,163 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime, posix_memalign and pthreads with -std=c99
+
+#include "platform.h"
+
+#include <time.h>
+
+// the thread entry point signature differs per platform, so the actual function + arg are passed through this struct
+typedef struct PlatformThreadStart {
+    PlatformThreadFunction function;
+    void *arg;
+} PlatformThreadStart;
+
+#ifdef _WIN32
+static DWORD WINAPI platform_thread_entry(LPVOID param) {
+#else
+static void *platform_thread_entry(void *param) {
+#endif
+    PlatformThreadStart start = *(PlatformThreadStart *)param;
+    free(param);
+    start.function(start.arg);
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+// platform_thread_start runs function(arg) on a new thread
+BOOL platform_thread_start(PlatformThread *thread, PlatformThreadFunction function, void *arg) {
+    PlatformThreadStart *start = malloc(sizeof(PlatformThreadStart));
+    if (start == NULL) {
+        return FALSE;
+    }
+    start->function = function;
+    start->arg = arg;
+
+#ifdef _WIN32
+    *thread = CreateThread(NULL, 0, platform_thread_entry, start, 0, NULL);
+    if (*thread == NULL) {
+        free(start);
+        return FALSE;
+    }
+#else
+    if (pthread_create(thread, NULL, platform_thread_entry, start) != 0) {
+        free(start);
+        return FALSE;
+    }
+#endif
+
+    return TRUE;
+}
+
+void platform_thread_join(PlatformThread thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+BOOL platform_event_init(PlatformEvent *event) {
+#ifdef _WIN32
+    *event = CreateEvent(NULL, FALSE, FALSE, NULL);
+    return *event != NULL;
+#else
+    event->signaled = FALSE;
+    if (pthread_mutex_init(&event->mutex, NULL) != 0) {
+        return FALSE;
+    }
+    if (pthread_cond_init(&event->condition, NULL) != 0) {
+        pthread_mutex_destroy(&event->mutex);
+        return FALSE;
+    }
+    return TRUE;
+#endif
+}
+
+void platform_event_destroy(PlatformEvent *event) {
+#ifdef _WIN32
+    CloseHandle(*event);
+#else
+    pthread_cond_destroy(&event->condition);
+    pthread_mutex_destroy(&event->mutex);
+#endif
+}
+
+// platform_event_signal wakes up one thread that waits for event, if none is waiting the next platform_event_wait returns right away
+void platform_event_signal(PlatformEvent *event) {
+#ifdef _WIN32
+    SetEvent(*event);
+#else
+    pthread_mutex_lock(&event->mutex);
+    event->signaled = TRUE;
+    pthread_cond_signal(&event->condition);
+    pthread_mutex_unlock(&event->mutex);
+#endif
+}
+
+// platform_event_wait blocks until event is signaled (TRUE) or timeoutMs passed (FALSE), timeoutMs can be INFINITE
+BOOL platform_event_wait(PlatformEvent *event, DWORD timeoutMs) {
+#ifdef _WIN32
+    return WaitForSingleObject(*event, timeoutMs) == WAIT_OBJECT_0;
+#else
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += (long)(timeoutMs % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&event->mutex);
+    int result = 0;
+    while (!event->signaled && (result == 0)) {
+        result = (timeoutMs == INFINITE) ? pthread_cond_wait(&event->condition, &event->mutex)
+                                         : pthread_cond_timedwait(&event->condition, &event->mutex, &deadline);
+    }
+    BOOL signaled = event->signaled;
+    event->signaled = FALSE;
+    pthread_mutex_unlock(&event->mutex);
+    return signaled;
+#endif
+}
+
+// platform_monotonic_us returns microseconds since some arbitrary point in time (only useful for measuring durations)
+uint64_t platform_monotonic_us(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (uint64_t)(now.QuadPart / frequency.QuadPart) * 1000000 + (uint64_t)(now.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+#endif
+}
+
+// platform_aligned_alloc returns size bytes aligned to alignment (power of two, multiple of sizeof(void *)), free with platform_aligned_free
+void *platform_aligned_alloc(size_t alignment, size_t size) {
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    void *pointer = NULL;
+    if (posix_memalign(&pointer, alignment, size) != 0) {
+        return NULL;
+    }
+    return pointer;
+#endif
+}
+
+void platform_aligned_free(void *pointer) {
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    free(pointer);
+#endif
+}
@@ -0,0 +1,40 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#ifndef COMMON_H
+#include "common.h"
+#endif
+
+// Platform-specific threads, events, clocks and aligned allocations (pthreads on macOS / linux, win32 threads on windows)
+
+#ifndef INFINITE
+#define INFINITE 0xFFFFFFFF // wait forever
+#endif
+
+#ifdef _WIN32
+typedef HANDLE PlatformThread;
+typedef HANDLE PlatformEvent;
+#else
+#include <pthread.h>
+typedef pthread_t PlatformThread;
+// PlatformEvent is an auto-reset event: a signal wakes up one waiter (or the next one to wait), then the event is reset
+typedef struct PlatformEvent {
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    BOOL signaled;
+} PlatformEvent;
+#endif
+
+typedef void (*PlatformThreadFunction)(void *arg);
+
+BOOL platform_thread_start(PlatformThread *thread, PlatformThreadFunction function, void *arg);
+void platform_thread_join(PlatformThread thread);
+BOOL platform_event_init(PlatformEvent *event);
+void platform_event_destroy(PlatformEvent *event);
+void platform_event_signal(PlatformEvent *event);
+BOOL platform_event_wait(PlatformEvent *event, DWORD timeoutMs);
+uint64_t platform_monotonic_us(void);
+void *platform_aligned_alloc(size_t alignment, size_t size);
+void platform_aligned_free(void *pointer);
+
+#endif
@@ -0,0 +1,135 @@
+#include "presence.h"
+#include "logging.c"
+#include "main.h"
+
+// presence_copy_atr stores the ATR that pcsc reported together with the state change (no need for a separate SCardStatus call)
+static void presence_copy_atr(const SCARD_READERSTATE *state, PresenceResult *result) {
+    DWORD atrLength = state->cbAtr;
+    if (atrLength > sizeof(result->atr)) {
+        atrLength = sizeof(result->atr);
+    }
+    memcpy(result->atr, state->rgbAtr, atrLength);
+    result->atrLength = atrLength;
+}
+
+// presence_watcher_init learns the current state of 'reader' (returns immediately) and checks whether PnP notifications are supported
+// 'reader' must stay valid for as long as the watcher is used
+LONG presence_watcher_init(PresenceWatcher *watcher, SCARDCONTEXT hContext, const char *reader) {
+    memset(watcher, 0, sizeof(*watcher));
+    watcher->hContext = hContext;
+    watcher->states[0].szReader = reader;
+    watcher->states[0].dwCurrentState = SCARD_STATE_UNAWARE;
+    watcher->states[1].szReader = PNP_NOTIFICATION_READER;
+    watcher->states[1].dwCurrentState = SCARD_STATE_UNAWARE;
+    watcher->amountStates = 2;
+
+    // with SCARD_STATE_UNAWARE pcsc answers immediately with the current state
+    LONG lRet = SCardGetStatusChange(hContext, 0, watcher->states, watcher->amountStates);
+    if ((lRet == SCARD_S_SUCCESS || lRet == SCARD_E_TIMEOUT) && (watcher->states[1].dwEventState & SCARD_STATE_UNKNOWN)) {
+        LOG_DEBUG("PnP notifications are not supported, only watching %s", reader);
+        watcher->amountStates = 1;
+    } else if (lRet != SCARD_S_SUCCESS && lRet != SCARD_E_TIMEOUT) {
+        // some pcsc implementations refuse the whole call if they do not know the PnP pseudo-reader, retry without it
+        watcher->amountStates = 1;
+        lRet = SCardGetStatusChange(hContext, 0, watcher->states, watcher->amountStates);
+        if (lRet != SCARD_S_SUCCESS && lRet != SCARD_E_TIMEOUT) {
+            LOG_ERROR("Failed to get state of reader %s: 0x%x", reader, (unsigned int)lRet);
+            return lRet;
+        }
+    }
+
+    for (DWORD i = 0; i < watcher->amountStates; i++) {
+        watcher->states[i].dwCurrentState = watcher->states[i].dwEventState & ~SCARD_STATE_CHANGED;
+    }
+
+    return SCARD_S_SUCCESS;
+}
+
+// presence_card_present returns the last known state (no pcsc call)
+BOOL presence_card_present(const PresenceWatcher *watcher) {
+    return (watcher->states[0].dwCurrentState & SCARD_STATE_PRESENT) != 0;
+}
+
+// presence_wait blocks until a tag is placed on / removed from the reader, or a reader is plugged in / out (timeoutMs can be INFINITE)
+// state changes that do not matter here (e.g. another application starts using the tag) are swallowed without returning
+PresenceEvent presence_wait(PresenceWatcher *watcher, DWORD timeoutMs, PresenceResult *result) {
+    memset(result, 0, sizeof(*result));
+
+    for (;;) {
+        LONG lRet = SCardGetStatusChange(watcher->hContext, timeoutMs, watcher->states, watcher->amountStates);
+        result->status = lRet;
+        if (lRet == SCARD_E_TIMEOUT) {
+            result->event = PRESENCE_TIMEOUT;
+            return result->event;
+        }
+        if (lRet != SCARD_S_SUCCESS) {
+            result->event = PRESENCE_ERROR;
+            return result->event;
+        }
+
+        // PnP pseudo-reader: the amount of readers changed
+        if ((watcher->amountStates == 2) && (watcher->states[1].dwEventState & SCARD_STATE_CHANGED)) {
+            watcher->states[1].dwCurrentState = watcher->states[1].dwEventState & ~SCARD_STATE_CHANGED;
+            result->event = PRESENCE_READERS_CHANGED;
+            return result->event;
+        }
+
+        SCARD_READERSTATE *state = &watcher->states[0];
+        if (!(state->dwEventState & SCARD_STATE_CHANGED)) {
+            continue;
+        }
+
+        DWORD previous = state->dwCurrentState;
+        DWORD current = state->dwEventState & ~SCARD_STATE_CHANGED;
+        state->dwCurrentState = current;
+
+        if (current & (SCARD_STATE_UNAVAILABLE | SCARD_STATE_UNKNOWN | SCARD_STATE_IGNORE)) {
+            result->event = PRESENCE_READER_UNAVAILABLE;
+            return result->event;
+        }
+        if ((current & SCARD_STATE_PRESENT) && !(previous & SCARD_STATE_PRESENT)) {
+            presence_copy_atr(state, result);
+            result->event = PRESENCE_CARD_INSERTED;
+            return result->event;
+        }
+        if (!(current & SCARD_STATE_PRESENT) && (previous & SCARD_STATE_PRESENT)) {
+            result->event = PRESENCE_CARD_REMOVED;
+            return result->event;
+        }
+    }
+}
+
+// presence_wait_for_card returns as soon as a tag is on the reader (immediately if one is already there) together with its ATR
+// removals and reader changes are skipped, only timeouts, errors and the reader disappearing end the wait early
+PresenceEvent presence_wait_for_card(PresenceWatcher *watcher, DWORD timeoutMs, PresenceResult *result) {
+    memset(result, 0, sizeof(*result));
+
+    // refresh the cached state first, the tag might have left since the last call
+    LONG lRet = SCardGetStatusChange(watcher->hContext, 0, watcher->states, 1);
+    if (lRet != SCARD_S_SUCCESS && lRet != SCARD_E_TIMEOUT) {
+        result->status = lRet;
+        result->event = PRESENCE_ERROR;
+        return result->event;
+    }
+    if (lRet == SCARD_S_SUCCESS) {
+        watcher->states[0].dwCurrentState = watcher->states[0].dwEventState & ~SCARD_STATE_CHANGED;
+    }
+
+    if (presence_card_present(watcher)) {
+        presence_copy_atr(&watcher->states[0], result);
+        result->event = PRESENCE_CARD_INSERTED;
+        return result->event;
+    }
+
+    for (;;) {
+        PresenceEvent event = presence_wait(watcher, timeoutMs, result);
+        if (event != PRESENCE_CARD_REMOVED && event != PRESENCE_READERS_CHANGED) {
+            return event;
+        }
+    }
+}
+
+// presence_cancel wakes up a thread that is blocked in presence_wait (it returns PRESENCE_ERROR with SCARD_E_CANCELLED)
+LONG presence_cancel(PresenceWatcher *watcher) {
+    return SCardCancel(watcher->hContext);
+}
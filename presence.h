@@ -0,0 +1,54 @@
+#ifndef PRESENCE_H
+#define PRESENCE_H
+
+#ifndef MAIN_H
+#include "main.h"
+#endif
+
+#ifndef COMMON_H
+#include "common.h"
+#endif
+
+#ifndef LOGGING_C
+#include "logging.c"
+#endif
+
+// The presence watcher waits for tags via SCardGetStatusChange instead of polling SCardConnect.
+// The calling thread sleeps inside pcsc until the reader reports a change, so the latency between tap and operation is the driver's own event latency.
+// It also watches the "\\?PnP?\Notification" pseudo-reader (if supported by the pcsc implementation) to notice readers being plugged in or out.
+
+#ifndef INFINITE
+#define INFINITE 0xFFFFFFFF // wait forever (pcsc timeout)
+#endif
+
+#define PNP_NOTIFICATION_READER "\\\\?PnP?\\Notification"
+
+typedef enum PresenceEvent {
+    PRESENCE_CARD_INSERTED,
+    PRESENCE_CARD_REMOVED,
+    PRESENCE_READERS_CHANGED,       // a reader was plugged in or out (re-enumerate with getAvailableReaders)
+    PRESENCE_READER_UNAVAILABLE,    // the watched reader is gone
+    PRESENCE_TIMEOUT,
+    PRESENCE_ERROR,                 // see PresenceResult.status
+} PresenceEvent;
+
+typedef struct PresenceResult {
+    PresenceEvent event;
+    LONG status;                    // pcsc return code of SCardGetStatusChange
+    BYTE atr[36];                   // ATR of the inserted tag (PRESENCE_CARD_INSERTED only)
+    DWORD atrLength;
+} PresenceResult;
+
+typedef struct PresenceWatcher {
+    SCARDCONTEXT hContext;
+    SCARD_READERSTATE states[2];    // [0]: the watched reader, [1]: PnP pseudo-reader
+    DWORD amountStates;             // 1 if PnP notifications are not supported
+} PresenceWatcher;
+
+LONG presence_watcher_init(PresenceWatcher *watcher, SCARDCONTEXT hContext, const char *reader);
+BOOL presence_card_present(const PresenceWatcher *watcher);
+PresenceEvent presence_wait(PresenceWatcher *watcher, DWORD timeoutMs, PresenceResult *result);
+PresenceEvent presence_wait_for_card(PresenceWatcher *watcher, DWORD timeoutMs, PresenceResult *result);
+LONG presence_cancel(PresenceWatcher *watcher);
+
+#endif
@@ -0,0 +1,140 @@
+#include "reader-pool.h"
+#include "logging.c"
+#include "main.h"
+
+// reader_pool_next_job takes the next job for the tag that is on the reader of worker, waiting for one to be submitted if necessary.
+// FALSE: the pool is finishing and no job is left
+static BOOL reader_pool_next_job(ReaderWorker *worker, Job *job) {
+    ReaderPool *pool = worker->pool;
+    for (;;) {
+        if (job_queue_pop(&pool->queue, job)) {
+            return TRUE;
+        }
+        if (job_queue_is_drained(&pool->queue)) {
+            return FALSE;
+        }
+        platform_event_wait(&worker->jobPushed, INFINITE);
+    }
+}
+
+static void reader_pool_worker(void *arg) {
+    ReaderWorker *worker = (ReaderWorker *)arg;
+    ReaderPool *pool = worker->pool;
+    ReaderSession *session = &worker->session;
+
+    // every worker has its own pcsc context, pcsc handles must not be shared between threads
+    worker->status = reader_session_open(session, worker->reader);
+    if (worker->status != SCARD_S_SUCCESS) {
+        LOG_ERROR("Failed to open reader %s: 0x%x", worker->reader, (unsigned int)worker->status);
+        return;
+    }
+
+    for (;;) {
+        // the tag comes first: a job is only taken by a reader that has a tag for it
+        LONG lRet = reader_session_begin_tag(session, READER_POOL_CLOSE_CHECK_MS);
+        if (lRet == SCARD_E_TIMEOUT) {
+            if (job_queue_is_drained(&pool->queue)) {
+                break;
+            }
+            continue;
+        }
+        if (lRet != SCARD_S_SUCCESS) {
+            LOG_ERROR("Reader %s failed: 0x%x", worker->reader, (unsigned int)lRet);
+            worker->status = lRet;
+            break;
+        }
+
+        Job job;
+        if (!reader_pool_next_job(worker, &job)) {
+            break; // nothing left to do with this tag, reader_session_close releases it
+        }
+
+        if (job.run(session->acr, job.arg)) {
+            worker->jobsSucceeded++;
+            session->tagsProcessed++;
+        } else {
+            LOG_WARN("Job %u failed on reader %s", job.id, worker->reader);
+            worker->jobsFailed++;
+            session->tagsFailed++;
+        }
+
+        lRet = reader_session_end_tag(session, TRUE);
+        if (lRet != SCARD_S_SUCCESS) {
+            LOG_ERROR("Reader %s failed while waiting for the tag to be removed: 0x%x", worker->reader, (unsigned int)lRet);
+            worker->status = lRet;
+            break;
+        }
+    }
+
+    reader_session_close(session);
+}
+
+// reader_pool_start enumerates all ACR122 readers and starts one worker per reader, the pool must not be moved in memory afterwards
+LONG reader_pool_start(ReaderPool *pool) {
+    memset(pool, 0, sizeof(*pool));
+    job_queue_init(&pool->queue);
+
+    SCARDCONTEXT hContext;
+    LONG lRet = SCardEstablishContext(SCARD_SCOPE_SYSTEM, NULL, NULL, &hContext);
+    if (lRet != SCARD_S_SUCCESS) {
+        LOG_CRITICAL("Failed to establish context: 0x%X", (unsigned int)lRet);
+        return lRet;
+    }
+
+    char readers[READER_POOL_MAX_READERS][256];
+    DWORD amountReaders = findAcr122Readers(hContext, readers, READER_POOL_MAX_READERS);
+    SCardReleaseContext(hContext);
+    if (amountReaders == 0) {
+        LOG_CRITICAL("No ACR122U found.");
+        return SCARD_E_UNKNOWN_READER;
+    }
+
+    for (DWORD i = 0; i < amountReaders; i++) {
+        ReaderWorker *worker = &pool->workers[pool->amountWorkers];
+        worker->pool = pool;
+        memcpy(worker->reader, readers[i], sizeof(worker->reader));
+
+        if (!platform_event_init(&worker->jobPushed)) {
+            LOG_ERROR("Failed to create the job event for reader %s", worker->reader);
+            continue;
+        }
+        if (!platform_thread_start(&worker->thread, reader_pool_worker, worker)) {
+            LOG_ERROR("Failed to start worker thread for reader %s", worker->reader);
+            platform_event_destroy(&worker->jobPushed);
+            continue;
+        }
+        LOG_INFO("Started worker for reader %s", worker->reader);
+        pool->amountWorkers++;
+    }
+
+    return (pool->amountWorkers > 0) ? SCARD_S_SUCCESS : SCARD_E_NO_MEMORY;
+}
+
+// reader_pool_wake_workers wakes up the workers that hold a tag and wait for a job
+static void reader_pool_wake_workers(ReaderPool *pool) {
+    for (DWORD i = 0; i < pool->amountWorkers; i++) {
+        platform_event_signal(&pool->workers[i].jobPushed);
+    }
+}
+
+// reader_pool_submit queues a job for the next reader that gets a tag, returns FALSE if the queue is full (retry later)
+BOOL reader_pool_submit(ReaderPool *pool, const Job *job) {
+    if (!job_queue_push(&pool->queue, job)) {
+        return FALSE;
+    }
+    reader_pool_wake_workers(pool);
+    return TRUE;
+}
+
+// reader_pool_finish lets the workers drain the queue (each remaining job still needs a tag) and waits for them to exit.
+// idle readers notice within READER_POOL_CLOSE_CHECK_MS, nobody has to tap them
+void reader_pool_finish(ReaderPool *pool) {
+    job_queue_close(&pool->queue);
+    reader_pool_wake_workers(pool);
+    for (DWORD i = 0; i < pool->amountWorkers; i++) {
+        platform_thread_join(pool->workers[i].thread);
+        platform_event_destroy(&pool->workers[i].jobPushed);
+        LOG_INFO("Reader %s: %lu jobs succeeded, %lu failed", pool->workers[i].reader,
+            (unsigned long)pool->workers[i].jobsSucceeded, (unsigned long)pool->workers[i].jobsFailed);
+    }
+}
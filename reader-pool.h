@@ -0,0 +1,61 @@
+#ifndef READER_POOL_H
+#define READER_POOL_H
+
+#ifndef MAIN_H
+#include "main.h"
+#endif
+
+#ifndef COMMON_H
+#include "common.h"
+#endif
+
+#ifndef LOGGING_C
+#include "logging.c"
+#endif
+
+#ifndef READER_SESSION_H
+#include "reader-session.h"
+#endif
+
+#ifndef JOB_QUEUE_H
+#include "job-queue.h"
+#endif
+
+#ifndef PLATFORM_H
+#include "platform.h"
+#endif
+
+// A ReaderPool drives every connected ACR122 at once: one worker thread per reader, each with its own ReaderSession
+// (pcsc context, card handle and acr_session, nothing is shared between readers). Jobs are pushed to a lock-free JobQueue.
+// Every worker waits for a tag on its reader first and only then takes the next job, so whichever reader gets a tag first
+// takes the next job and no job is ever held by an idle reader.
+// Readers never wait on each other, so the amount of tags per minute grows with the amount of readers (and operators).
+
+#define READER_POOL_MAX_READERS 16
+#define READER_POOL_CLOSE_CHECK_MS 500 // an idle worker blocks in pcsc waiting for a tag, this often it checks whether reader_pool_finish was called
+
+struct ReaderPool;
+
+typedef struct ReaderWorker {
+    struct ReaderPool *pool;
+    char reader[256];
+    ReaderSession session;          // only touched by the worker thread
+    PlatformThread thread;
+    PlatformEvent jobPushed;        // signaled by reader_pool_submit / reader_pool_finish, waited for while a tag has no job yet
+    LONG status;                    // SCARD_S_SUCCESS unless the reader failed (e.g. it was unplugged)
+    // statistics
+    DWORD jobsSucceeded;
+    DWORD jobsFailed;
+} ReaderWorker;
+
+typedef struct ReaderPool {
+    JobQueue queue;
+    ReaderWorker workers[READER_POOL_MAX_READERS];
+    DWORD amountWorkers;
+} ReaderPool;
+
+LONG reader_pool_start(ReaderPool *pool);
+BOOL reader_pool_submit(ReaderPool *pool, const Job *job);
+void reader_pool_finish(ReaderPool *pool);
+
+#endif
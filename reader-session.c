@@ -0,0 +1,161 @@
+#include "reader-session.h"
+#include "logging.c"
+#include "main.h"
+
+// reader_session_open establishes the pcsc context, picks the reader (readerName, or the first ACR122 if NULL) and applies the reader configuration once
+// the session must not be moved in memory afterwards (the presence watcher points at session->reader)
+LONG reader_session_open(ReaderSession *session, const char *readerName) {
+    memset(session, 0, sizeof(*session));
+
+    session->acr = acr_session_create(0);
+    if (session->acr == NULL) {
+        LOG_CRITICAL("Failed to allocate session");
+        return SCARD_E_NO_MEMORY;
+    }
+
+    LONG lRet = SCardEstablishContext(SCARD_SCOPE_SYSTEM, NULL, NULL, &session->hContext);
+    if (lRet != SCARD_S_SUCCESS) {
+        LOG_CRITICAL("Failed to establish context: 0x%X", (unsigned int)lRet);
+        acr_session_destroy(session->acr);
+        return lRet;
+    }
+
+    // pick the reader
+    if (readerName != NULL) {
+        strncpy(session->reader, readerName, sizeof(session->reader) - 1);
+    } else {
+        if (findAcr122Readers(session->hContext, &session->reader, 1) == 0) {
+            LOG_CRITICAL("No ACR122U found.");
+            SCardReleaseContext(session->hContext);
+            acr_session_destroy(session->acr);
+            return SCARD_E_UNKNOWN_READER;
+        }
+    }
+
+    // reader configuration is applied only once per session (needs a direct connection, which is dropped again right away)
+    SCARDHANDLE hDirect = 0;
+    BYTE pbRecvBuffer[16];
+    DWORD pbRecvBufferSize = sizeof(pbRecvBuffer);
+    lRet = disableBuzzer(session->hContext, session->reader, &hDirect, &session->dwActiveProtocol, pbRecvBuffer, &pbRecvBufferSize);
+    if (lRet == SCARD_S_SUCCESS) {
+        LOG_INFO("Disabled buzzer of reader %s", session->reader);
+    } else {
+        LOG_WARN("Failed to disable buzzer of reader %s: 0x%x", session->reader, (unsigned int)lRet);
+    }
+    if (hDirect != 0) {
+        SCardDisconnect(hDirect, SCARD_LEAVE_CARD);
+    }
+
+    lRet = presence_watcher_init(&session->watcher, session->hContext, session->reader);
+    if (lRet != SCARD_S_SUCCESS) {
+        SCardReleaseContext(session->hContext);
+        acr_session_destroy(session->acr);
+        return lRet;
+    }
+
+    return SCARD_S_SUCCESS;
+}
+
+// reader_session_begin_tag waits for the next tag (timeoutMs can be INFINITE) and connects to it
+// the first tag uses SCardConnect, every further tag re-uses the handle via SCardReconnect
+LONG reader_session_begin_tag(ReaderSession *session, DWORD timeoutMs) {
+    for (;;) {
+        PresenceResult presence;
+        PresenceEvent event = presence_wait_for_card(&session->watcher, timeoutMs, &presence);
+        if (event == PRESENCE_TIMEOUT) {
+            return SCARD_E_TIMEOUT;
+        }
+        if (event != PRESENCE_CARD_INSERTED) {
+            return (presence.status != SCARD_S_SUCCESS) ? presence.status : SCARD_E_READER_UNAVAILABLE;
+        }
+        memcpy(session->atr, presence.atr, presence.atrLength);
+        session->atrLength = presence.atrLength;
+
+        LONG lRet;
+        if (session->hCard == 0) {
+            lRet = connectToReader(session->hContext, session->reader, &session->hCard, &session->dwActiveProtocol, FALSE);
+        } else {
+            lRet = SCardReconnect(session->hCard, SCARD_SHARE_SHARED, SCARD_PROTOCOL_T1, SCARD_LEAVE_CARD, &session->dwActiveProtocol);
+        }
+
+        if ((lRet == SCARD_E_NO_SMARTCARD) || (lRet == SCARD_W_REMOVED_CARD)) {
+            continue; // tag was taken away again before we could connect, wait for the next one
+        }
+        if ((lRet == SCARD_E_INVALID_HANDLE) && (session->hCard != 0)) {
+            // pcsc dropped our handle (e.g. pcscd restarted), fall back to a fresh connect
+            session->hCard = 0;
+            continue;
+        }
+        if (lRet == SCARD_S_SUCCESS) {
+            acr_session_set_handle(session->acr, session->hCard); // also forgets everything cached about the previous tag
+        }
+        return lRet;
+    }
+}
+
+// reader_session_end_tag finishes the current tag, optionally blocking until it is taken off the reader (so it is not processed twice)
+// the handle is kept (SCARD_LEAVE_CARD) so that the next tag only needs a reconnect
+LONG reader_session_end_tag(ReaderSession *session, BOOL waitForRemoval) {
+    if (!waitForRemoval) {
+        return SCARD_S_SUCCESS;
+    }
+
+    while (presence_card_present(&session->watcher)) {
+        PresenceResult presence;
+        PresenceEvent event = presence_wait(&session->watcher, INFINITE, &presence);
+        if (event == PRESENCE_ERROR) {
+            return presence.status;
+        }
+        if (event == PRESENCE_READER_UNAVAILABLE) {
+            return SCARD_E_READER_UNAVAILABLE;
+        }
+    }
+
+    return SCARD_S_SUCCESS;
+}
+
+// reader_session_run processes tags until maxTags tags were processed (0: forever) or the reader fails
+LONG reader_session_run(ReaderSession *session, const ReaderSessionHooks *hooks, void *userData, DWORD maxTags) {
+    while ((maxTags == 0) || (session->tagsProcessed + session->tagsFailed < maxTags)) {
+        LONG lRet = reader_session_begin_tag(session, INFINITE);
+        if (lRet != SCARD_S_SUCCESS) {
+            LOG_ERROR("Failed to connect to the next tag: 0x%x", (unsigned int)lRet);
+            return lRet;
+        }
+
+        BOOL success = TRUE;
+        if ((hooks->onTagBegin != NULL) && !hooks->onTagBegin(session, userData)) {
+            success = FALSE;
+        } else if (hooks->onTag != NULL) {
+            success = hooks->onTag(session, userData);
+        }
+
+        if (success) {
+            session->tagsProcessed++;
+        } else {
+            session->tagsFailed++;
+        }
+
+        if (hooks->onTagEnd != NULL) {
+            hooks->onTagEnd(session, success, userData);
+        }
+
+        lRet = reader_session_end_tag(session, TRUE);
+        if (lRet != SCARD_S_SUCCESS) {
+            LOG_ERROR("Failed to wait for removal of the tag: 0x%x", (unsigned int)lRet);
+            return lRet;
+        }
+    }
+
+    return SCARD_S_SUCCESS;
+}
+
+void reader_session_close(ReaderSession *session) {
+    if (session->hCard != 0) {
+        SCardDisconnect(session->hCard, SCARD_LEAVE_CARD);
+        session->hCard = 0;
+    }
+    SCardReleaseContext(session->hContext);
+    acr_session_destroy(session->acr);
+    session->acr = NULL;
+}
@@ -0,0 +1,52 @@
+#ifndef READER_SESSION_H
+#define READER_SESSION_H
+
+#ifndef MAIN_H
+#include "main.h"
+#endif
+
+#ifndef COMMON_H
+#include "common.h"
+#endif
+
+#ifndef LOGGING_C
+#include "logging.c"
+#endif
+
+#ifndef PRESENCE_H
+#include "presence.h"
+#endif
+
+// A ReaderSession is meant for encoding many tags in a row: the pcsc context, the reader configuration (buzzer) and the card handle
+// are set up once, and between tags the handle is only re-established via SCardReconnect (SCARD_LEAVE_CARD).
+// That way the steady-state cost per tag is the presence event, one reconnect and the APDUs of the tag itself.
+
+typedef struct ReaderSession {
+    SCARDCONTEXT hContext;
+    char reader[256];
+    SCARDHANDLE hCard;              // 0 until the first tag was connected
+    DWORD dwActiveProtocol;
+    PresenceWatcher watcher;
+    // the tag that is currently being processed
+    BYTE atr[36];
+    DWORD atrLength;
+    acr_session *acr;               // handle, receive buffers and cached tag state that the drivers work with
+    // statistics
+    DWORD tagsProcessed;
+    DWORD tagsFailed;
+} ReaderSession;
+
+// ReaderSessionHooks are called for every tag by reader_session_run, any of them can be NULL
+typedef struct ReaderSessionHooks {
+    BOOL (*onTagBegin)(ReaderSession *session, void *userData);             // tag is connected, return FALSE to skip it
+    BOOL (*onTag)(ReaderSession *session, void *userData);                  // the actual work, return FALSE on failure
+    void (*onTagEnd)(ReaderSession *session, BOOL success, void *userData); // before waiting for the tag to be removed
+} ReaderSessionHooks;
+
+LONG reader_session_open(ReaderSession *session, const char *readerName);
+LONG reader_session_begin_tag(ReaderSession *session, DWORD timeoutMs);
+LONG reader_session_end_tag(ReaderSession *session, BOOL waitForRemoval);
+LONG reader_session_run(ReaderSession *session, const ReaderSessionHooks *hooks, void *userData, DWORD maxTags);
+void reader_session_close(ReaderSession *session);
+
+#endif
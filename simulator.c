@@ -0,0 +1,762 @@
+#include "simulator.h"
+#include "logging.c"
+#include "main.h"
+
+#define SIM_FRAME_SIZE 256 // the PN532 can only transfer 256 bytes at once (d5 43 00 + data + 90 00 must fit into that)
+
+// ballpark figures for an ACR122U, the UART between its MCU and the PN532 dominates the cost of large transfers
+const SimLatencyModel SIM_LATENCY_ACR122U = {
+    .apdu_us = 4000,
+    .byte_us = 87,
+    .rf_us = 1000,
+    .auth_us = 2500,
+    .lock_us = 250, // context switch to pcscd and back + the reader lock (much more than the mutex itself)
+    .realtime = FALSE,
+};
+
+const SimLatencyModel SIM_LATENCY_NONE = {0};
+
+// SimTagInfo describes the memory layout and identification bytes of a simulated tag type
+typedef struct SimTagInfo {
+    const char *name;
+    BOOL isClassic;
+    DWORD memorySize;       // in bytes
+    BYTE sak;               // classic only
+    BYTE atqa[2];           // classic only
+    BYTE version[8];        // GET_VERSION response (ntag / ultralight ev1 only, all zeroes: the tag refuses GET_VERSION and has no configuration pages)
+    BYTE cc[4];             // capability container in page 3 (ntag / ultralight only)
+    BYTE counters;          // 3: ultralight ev1 (READ_CNT + INCR_CNT), 1: ntag (READ_CNT 0x02 only)
+} SimTagInfo;
+
+static const SimTagInfo SIM_TAG_INFO[] = {
+    [SIM_MIFARE_CLASSIC_1K] = { "Mifare Classic 1k", TRUE, 64 * 16, 0x08, { 0x04, 0x00 }, {0}, {0}, 0 },
+    [SIM_MIFARE_CLASSIC_4K] = { "Mifare Classic 4k", TRUE, 256 * 16, 0x18, { 0x02, 0x00 }, {0}, {0}, 0 },
+    [SIM_MIFARE_MINI] = { "Mifare Mini", TRUE, 20 * 16, 0x09, { 0x04, 0x00 }, {0}, {0}, 0 },
+    [SIM_NTAG_213] = { "NTAG 213", FALSE, 45 * 4, 0x00, {0}, { 0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x0F, 0x03 }, { 0xE1, 0x10, 0x12, 0x00 }, 1 },
+    [SIM_NTAG_215] = { "NTAG 215", FALSE, 135 * 4, 0x00, {0}, { 0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x11, 0x03 }, { 0xE1, 0x10, 0x3E, 0x00 }, 1 },
+    [SIM_NTAG_216] = { "NTAG 216", FALSE, 231 * 4, 0x00, {0}, { 0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x13, 0x03 }, { 0xE1, 0x10, 0x6D, 0x00 }, 1 },
+    [SIM_ULTRALIGHT_EV1] = { "Mifare Ultralight EV1", FALSE, 20 * 4, 0x00, {0}, { 0x00, 0x04, 0x03, 0x01, 0x01, 0x00, 0x0B, 0x03 }, { 0x00, 0x00, 0x00, 0x00 }, 3 },
+    [SIM_ULTRALIGHT] = { "Mifare Ultralight", FALSE, 16 * 4, 0x00, {0}, {0}, { 0xE1, 0x10, 0x06, 0x00 }, 0 },
+};
+
+static const BYTE SIM_UNINITIALIZED_SECTOR_TRAILER[16] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x07, 0x80, 0x69, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+// handles that were given out by sim_connect (handle = index + 1, so that 0 stays 'no handle')
+static SimReader *simReaders[SIM_MAX_READERS];
+
+// -------------------- Helpers -------------------------------
+
+static const SimTagInfo *sim_info(const SimReader *reader) {
+    return &SIM_TAG_INFO[reader->type];
+}
+
+static void sim_sleep_us(uint64_t microseconds) {
+#ifdef _WIN32
+    Sleep((DWORD)(microseconds / 1000));
+#else
+    // usleep is only guaranteed to accept values below one second
+    while (microseconds > 0) {
+        uint64_t chunk = (microseconds > 500000) ? 500000 : microseconds;
+        usleep((unsigned int)chunk);
+        microseconds -= chunk;
+    }
+#endif
+}
+
+// sim_account adds the modelled cost of one APDU to the statistics of the reader (and sleeps for it in realtime mode)
+static void sim_account(SimReader *reader, DWORD bytes, BOOL rf, BOOL auth) {
+    uint64_t cost = reader->latency.apdu_us + (uint64_t)bytes * reader->latency.byte_us;
+    if (rf) cost += reader->latency.rf_us;
+    if (auth) cost += reader->latency.auth_us;
+    if (!reader->inTransaction) cost += reader->latency.lock_us;
+
+    reader->apduCount++;
+    reader->elapsed_us += cost;
+    if (reader->latency.realtime) {
+        sim_sleep_us(cost);
+    }
+}
+
+static DWORD sim_status(BYTE *response, DWORD length, BYTE sw1, BYTE sw2) {
+    response[length] = sw1;
+    response[length + 1] = sw2;
+    return length + 2;
+}
+
+// -------------------- Mifare Classic -------------------------------
+
+static int sim_classic_sector_of_block(DWORD block) {
+    return (block < 128) ? (int)(block / 4) : (int)(32 + (block - 128) / 16);
+}
+
+static DWORD sim_classic_trailer_of_sector(int sector) {
+    return (sector < 32) ? (DWORD)(sector * 4 + 3) : (DWORD)(128 + (sector - 32) * 16 + 15);
+}
+
+// sim_classic_authenticate runs the three pass authentication, a tag that fails it halts (see sim_in_list_passive_target)
+static BOOL sim_classic_authenticate(SimReader *reader, DWORD block, BYTE keyType, BYTE slot) {
+    reader->authenticatedSector = -1;
+
+    if (block >= reader->memorySize / 16 || slot > 0x01 || !reader->keyLoaded[slot]) {
+        return FALSE; // the reader does not even try
+    }
+    reader->halted = TRUE;
+
+    int sector = sim_classic_sector_of_block(block);
+    const BYTE *trailer = reader->memory + sim_classic_trailer_of_sector(sector) * 16;
+    const BYTE *expectedKey;
+    if (keyType == 0x60) {
+        expectedKey = trailer;          // key A
+    } else if (keyType == 0x61) {
+        expectedKey = trailer + 10;     // key B
+    } else {
+        return FALSE;
+    }
+
+    if (memcmp(expectedKey, reader->keys[slot], 6) != 0) {
+        return FALSE;
+    }
+
+    reader->halted = FALSE;
+    reader->authenticatedSector = sector;
+    return TRUE;
+}
+
+static DWORD sim_classic_read(SimReader *reader, BYTE block, BYTE length, BYTE *response) {
+    if (block >= reader->memorySize / 16 || length != 0x10 || sim_classic_sector_of_block(block) != reader->authenticatedSector) {
+        return sim_status(response, 0, 0x63, 0x00);
+    }
+
+    memcpy(response, reader->memory + block * 16, 16);
+    if (block == sim_classic_trailer_of_sector(reader->authenticatedSector)) {
+        memset(response, 0x00, 6); // key A can never be read back
+    }
+    return sim_status(response, 16, 0x90, 0x00);
+}
+
+static DWORD sim_classic_write(SimReader *reader, BYTE block, const BYTE *data, BYTE length, BYTE *response) {
+    if (block == 0x00 || block >= reader->memorySize / 16 || length != 0x10 || sim_classic_sector_of_block(block) != reader->authenticatedSector) {
+        return sim_status(response, 0, 0x63, 0x00);
+    }
+
+    memcpy(reader->memory + block * 16, data, 16);
+    return sim_status(response, 0, 0x90, 0x00);
+}
+
+// value blocks: value (LSB first), inverted value, value, address, inverted address, address, inverted address
+static BOOL sim_classic_parse_value(const BYTE *block, int32_t *value) {
+    for (int i = 0; i < 4; i++) {
+        if (block[i] != block[i + 8] || (BYTE)(block[i] ^ block[i + 4]) != 0xFF) {
+            return FALSE;
+        }
+    }
+    if (block[12] != block[14] || block[13] != block[15] || (BYTE)(block[12] ^ block[13]) != 0xFF) {
+        return FALSE;
+    }
+    *value = (int32_t)((uint32_t)block[0] | ((uint32_t)block[1] << 8) | ((uint32_t)block[2] << 16) | ((uint32_t)block[3] << 24));
+    return TRUE;
+}
+
+static void sim_classic_store_value(BYTE *block, int32_t value, BYTE address) {
+    for (int i = 0; i < 4; i++) {
+        block[i] = block[i + 8] = (BYTE)((uint32_t)value >> (8 * i));
+        block[i + 4] = (BYTE)~block[i];
+    }
+    block[12] = block[14] = address;
+    block[13] = block[15] = (BYTE)~address;
+}
+
+static BOOL sim_classic_value_block_usable(const SimReader *reader, BYTE block) {
+    return block != 0x00 && block < reader->memorySize / 16 && sim_classic_sector_of_block(block) == reader->authenticatedSector &&
+        block != sim_classic_trailer_of_sector(reader->authenticatedSector);
+}
+
+// sim_classic_read_value answers FF B1 (value MSB first)
+static DWORD sim_classic_read_value(SimReader *reader, BYTE block, BYTE length, BYTE *response) {
+    int32_t value;
+    if (length != 0x04 || !sim_classic_value_block_usable(reader, block) || !sim_classic_parse_value(reader->memory + block * 16, &value)) {
+        return sim_status(response, 0, 0x63, 0x00);
+    }
+    for (int i = 0; i < 4; i++) {
+        response[i] = (BYTE)((uint32_t)value >> (24 - 8 * i));
+    }
+    return sim_status(response, 4, 0x90, 0x00);
+}
+
+// sim_classic_value_operation answers FF D7: 05 op value (00 store, 01 increment, 02 decrement, value MSB first) or 02 03 target (restore + transfer)
+static DWORD sim_classic_value_operation(SimReader *reader, BYTE block, const BYTE *data, BYTE length, BYTE *response) {
+    if (!sim_classic_value_block_usable(reader, block)) {
+        return sim_status(response, 0, 0x63, 0x00);
+    }
+    BYTE *memory = reader->memory + block * 16;
+
+    if (length == 0x02 && data[0] == 0x03) {
+        int32_t value;
+        if (!sim_classic_value_block_usable(reader, data[1]) || !sim_classic_parse_value(memory, &value)) {
+            return sim_status(response, 0, 0x63, 0x00);
+        }
+        sim_classic_store_value(reader->memory + data[1] * 16, value, memory[12]);
+        return sim_status(response, 0, 0x90, 0x00);
+    }
+    if (length != 0x05 || data[0] > 0x02) {
+        return sim_status(response, 0, 0x63, 0x00);
+    }
+
+    int32_t operand = (int32_t)(((uint32_t)data[1] << 24) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 8) | (uint32_t)data[4]);
+    int32_t value;
+    if (data[0] == 0x00) {
+        sim_classic_store_value(memory, operand, block);
+        return sim_status(response, 0, 0x90, 0x00);
+    }
+    if (!sim_classic_parse_value(memory, &value)) {
+        return sim_status(response, 0, 0x63, 0x00);
+    }
+    uint32_t result = (data[0] == 0x01) ? (uint32_t)value + (uint32_t)operand : (uint32_t)value - (uint32_t)operand; // wraps like the tag does
+    sim_classic_store_value(memory, (int32_t)result, memory[12]);
+    return sim_status(response, 0, 0x90, 0x00);
+}
+
+// -------------------- NTAG / Ultralight -------------------------------
+
+static DWORD sim_type2_pages(const SimReader *reader) {
+    return reader->memorySize / 4;
+}
+
+// sim_type2_has_config tells whether the tag answers GET_VERSION and ends with the configuration pages (a plain Ultralight does neither)
+static BOOL sim_type2_has_config(const SimReader *reader) {
+    return sim_info(reader)->version[1] != 0x00;
+}
+
+// sim_type2_protected tells whether AUTH0 (CFG0 byte 3) and PROT (CFG1 bit 7) require PWD_AUTH before page can be written / read.
+// all simulated type 2 tags end with CFG0, CFG1, PWD, PACK
+static BOOL sim_type2_protected(const SimReader *reader, DWORD page, BOOL write) {
+    const BYTE *config = reader->memory + (sim_type2_pages(reader) - 4) * 4;
+    if (!sim_type2_has_config(reader) || reader->passwordAuthenticated || page < config[3]) {
+        return FALSE;
+    }
+    return write || (config[4] & 0x80) != 0;
+}
+
+// sim_type2_readable checks that none of the amount pages from page on (rolling over at the end of the tag) is read protected
+static BOOL sim_type2_readable(const SimReader *reader, DWORD page, DWORD amount) {
+    for (DWORD i = 0; i < amount; i++) {
+        if (sim_type2_protected(reader, (page + i) % sim_type2_pages(reader), FALSE)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// sim_type2_read_page copies a page, PWD and PACK always read back as zeroes
+static void sim_type2_read_page(const SimReader *reader, DWORD page, BYTE *out) {
+    if (sim_type2_has_config(reader) && (page >= sim_type2_pages(reader) - 2)) {
+        memset(out, 0x00, 4);
+        return;
+    }
+    memcpy(out, reader->memory + page * 4, 4);
+}
+
+static BOOL sim_type2_write_page(SimReader *reader, DWORD page, const BYTE *data) {
+    if (page < 2 || page >= sim_type2_pages(reader)) {
+        return FALSE; // pages 0 and 1 hold the UID
+    }
+    if (sim_type2_protected(reader, page, TRUE)) {
+        return FALSE;
+    }
+
+    BYTE *target = reader->memory + page * 4;
+    if (page == 2) {
+        // only the static lock bytes are writable and they can only be set, never cleared
+        target[2] |= data[2];
+        target[3] |= data[3];
+    } else if (page == 3) {
+        // capability container is OTP
+        for (int i = 0; i < 4; i++) {
+            target[i] |= data[i];
+        }
+    } else {
+        memcpy(target, data, 4);
+    }
+
+    return TRUE;
+}
+
+// sim_tag_error is how the reader answers a command that the tag refused (NAK) or did not answer at all: the status word still is 90 00
+static DWORD sim_tag_error(BYTE *response) {
+    response[0] = 0xd5;
+    response[1] = 0x43;
+    response[2] = PN532_STATUS_TIMEOUT;
+    return sim_status(response, 3, 0x90, 0x00);
+}
+
+// sim_tag_command answers the command that sim_in_communicate_thru forwards to the tag
+static DWORD sim_tag_command(SimReader *reader, const BYTE *command, DWORD commandLength, BYTE *response) {
+    const SimTagInfo *info = sim_info(reader);
+    DWORD pages = sim_type2_pages(reader);
+    DWORD length = 0;
+
+    if (info->isClassic || commandLength < 1) {
+        return sim_tag_error(response);
+    }
+
+    response[length++] = 0xd5;
+    response[length++] = 0x43;
+    response[length++] = 0x00;
+
+    switch (command[0]) {
+        case 0x30: // READ (4 pages, rolls over at the end of the tag)
+            if (commandLength != 2 || command[1] >= pages || !sim_type2_readable(reader, command[1], 4)) {
+                return sim_tag_error(response);
+            }
+            for (DWORD i = 0; i < 4; i++) {
+                sim_type2_read_page(reader, (command[1] + i) % pages, response + length);
+                length += 4;
+            }
+            break;
+
+        case 0x3A: // FAST_READ
+            if (commandLength != 3 || command[1] > command[2] || command[2] >= pages ||
+                !sim_type2_readable(reader, command[1], command[2] - command[1] + 1)) {
+                return sim_tag_error(response);
+            }
+            if (length + (DWORD)(command[2] - command[1] + 1) * 4 + 2 > SIM_FRAME_SIZE) {
+                return sim_tag_error(response); // does not fit into a single PN532 frame
+            }
+            for (DWORD page = command[1]; page <= command[2]; page++) {
+                sim_type2_read_page(reader, page, response + length);
+                length += 4;
+            }
+            break;
+
+        case 0xA2: // WRITE
+            if (commandLength != 6 || !sim_type2_write_page(reader, command[1], command + 2)) {
+                return sim_tag_error(response);
+            }
+            break;
+
+        case 0x39: // READ_CNT
+            if (commandLength != 2 || info->counters == 0 ||
+                (info->counters == 1 && command[1] != 0x02) || (info->counters == 3 && command[1] > 0x02)) {
+                return sim_tag_error(response);
+            }
+            memcpy(response + length, reader->counters[command[1]], 3);
+            length += 3;
+            break;
+
+        case 0xA5: { // INCR_CNT (ultralight ev1 only)
+            if (commandLength != 6 || info->counters != 3 || command[1] > 0x02) {
+                return sim_tag_error(response);
+            }
+            BYTE *counter = reader->counters[command[1]];
+            uint32_t value = counter[0] | (counter[1] << 8) | ((uint32_t)counter[2] << 16);
+            uint32_t increment = command[2] | (command[3] << 8) | ((uint32_t)command[4] << 16);
+            if (value + increment > 0xFFFFFF) {
+                return sim_tag_error(response); // the tag refuses to overflow
+            }
+            value += increment;
+            counter[0] = value & 0xFF;
+            counter[1] = (value >> 8) & 0xFF;
+            counter[2] = (value >> 16) & 0xFF;
+            break;
+        }
+
+        case 0x1B: // PWD_AUTH, answered with PACK
+            if (commandLength != 5 || !sim_type2_has_config(reader) || memcmp(command + 1, reader->memory + (pages - 2) * 4, 4) != 0) {
+                return sim_tag_error(response);
+            }
+            reader->passwordAuthenticated = TRUE;
+            memcpy(response + length, reader->memory + (pages - 1) * 4, 2);
+            length += 2;
+            break;
+
+        case 0x60: // GET_VERSION
+            if (commandLength != 1 || !sim_type2_has_config(reader)) {
+                return sim_tag_error(response);
+            }
+            memcpy(response + length, info->version, 8);
+            length += 8;
+            break;
+
+        default:
+            return sim_tag_error(response);
+    }
+
+    return sim_status(response, length, 0x90, 0x00);
+}
+
+// sim_in_communicate_thru handles the part of 'ff 00 00 00 Lc d4 42 ..' that is forwarded to the tag. on every error (NAK) the tag drops a PWD_AUTH
+// and halts: it does not answer anything until it is selected again (sim_in_list_passive_target)
+static DWORD sim_in_communicate_thru(SimReader *reader, const BYTE *command, DWORD commandLength, BYTE *response) {
+    if (reader->halted) {
+        return sim_tag_error(response);
+    }
+    DWORD length = sim_tag_command(reader, command, commandLength, response);
+    if (response[2] != PN532_STATUS_OK) {
+        reader->passwordAuthenticated = FALSE;
+        reader->halted = TRUE;
+    }
+    return length;
+}
+
+// sim_in_list_passive_target answers 'ff 00 00 00 04 d4 4a 01 00': the tag is selected again (every authentication is gone)
+// d5 4b 01 (one target) 01 (target number) SENS_RES (2 bytes) SEL_RES NFCID length NFCID 90 00
+static DWORD sim_in_list_passive_target(SimReader *reader, BYTE *response) {
+    const SimTagInfo *info = sim_info(reader);
+    reader->halted = FALSE;
+    reader->authenticatedSector = -1;
+    reader->passwordAuthenticated = FALSE;
+
+    DWORD length = 0;
+    response[length++] = 0xd5;
+    response[length++] = 0x4b;
+    response[length++] = 0x01;
+    response[length++] = 0x01;
+    response[length++] = info->isClassic ? info->atqa[1] : 0x00;
+    response[length++] = info->isClassic ? info->atqa[0] : 0x44;
+    response[length++] = info->sak;
+    response[length++] = reader->uidLength;
+    memcpy(response + length, reader->uid, reader->uidLength);
+    length += reader->uidLength;
+    return sim_status(response, length, 0x90, 0x00);
+}
+
+// -------------------- Transport -------------------------------
+
+static SimReader *sim_lookup(SCARDHANDLE hCard) {
+    if (hCard < 1 || hCard > SIM_MAX_READERS) {
+        return NULL;
+    }
+    return simReaders[hCard - 1];
+}
+
+// sim_handle_apdu emulates the ACR122U pseudo-APDUs (API-ACR122U-2.04), rf / auth are set when the APDU needs the tag / a crypto1 authentication
+static DWORD sim_handle_apdu(SimReader *reader, const BYTE *apdu, DWORD apduLength, BYTE *response, BOOL *rf, BOOL *auth) {
+    const SimTagInfo *info = sim_info(reader);
+
+    if (apduLength < 5 || apdu[0] != 0xFF) {
+        return sim_status(response, 0, 0x6A, 0x81);
+    }
+
+    BYTE ins = apdu[1];
+    BYTE p1 = apdu[2];
+    BYTE p2 = apdu[3];
+    BYTE lc = apdu[4];
+    const BYTE *data = apdu + 5;
+    DWORD dataLength = apduLength - 5;
+
+    // a halted tag does not answer anything but a new selection (sim_in_list_passive_target)
+    if (reader->halted && (ins == 0x86 || ins == 0x88 || ins == 0xB0 || ins == 0xD6 || ins == 0xB1 || ins == 0xD7)) {
+        *rf = TRUE;
+        return sim_status(response, 0, 0x63, 0x00);
+    }
+
+    switch (ins) {
+        case 0xCA: // get data: UID (P1 = 00) or ATS (P1 = 01, not supported by any of the simulated tags)
+            if (p1 != 0x00) {
+                return sim_status(response, 0, 0x6A, 0x81);
+            }
+            memcpy(response, reader->uid, reader->uidLength);
+            return sim_status(response, reader->uidLength, 0x90, 0x00);
+
+        case 0x82: // load authentication keys into volatile slot P2
+            if (p2 > 0x01 || lc != 0x06 || dataLength != 6) {
+                return sim_status(response, 0, 0x63, 0x00);
+            }
+            memcpy(reader->keys[p2], data, 6);
+            reader->keyLoaded[p2] = TRUE;
+            return sim_status(response, 0, 0x90, 0x00);
+
+        case 0x86: // authenticate: 01 00 block keyType slot
+            *rf = TRUE;
+            *auth = TRUE;
+            if (!info->isClassic || dataLength != 5 || data[0] != 0x01 || data[1] != 0x00 ||
+                !sim_classic_authenticate(reader, data[2], data[3], data[4])) {
+                return sim_status(response, 0, 0x63, 0x00);
+            }
+            return sim_status(response, 0, 0x90, 0x00);
+
+        case 0x88: // obsolete authenticate: P2 = block, data = keyType slot
+            *rf = TRUE;
+            *auth = TRUE;
+            if (!info->isClassic || apduLength != 6 || !sim_classic_authenticate(reader, p2, lc, apdu[5])) {
+                return sim_status(response, 0, 0x63, 0x00);
+            }
+            return sim_status(response, 0, 0x90, 0x00);
+
+        case 0xB0: // read binary blocks
+            *rf = TRUE;
+            if (info->isClassic) {
+                return sim_classic_read(reader, p2, lc, response);
+            }
+            if (p2 >= sim_type2_pages(reader) || lc == 0 || lc > 16 || !sim_type2_readable(reader, p2, 4)) {
+                return sim_status(response, 0, 0x63, 0x00);
+            }
+            for (DWORD i = 0; i < 4; i++) {
+                sim_type2_read_page(reader, (p2 + i) % sim_type2_pages(reader), response + i * 4);
+            }
+            return sim_status(response, lc, 0x90, 0x00);
+
+        case 0xD6: // update binary blocks
+            *rf = TRUE;
+            if (dataLength != lc) {
+                return sim_status(response, 0, 0x63, 0x00);
+            }
+            if (info->isClassic) {
+                return sim_classic_write(reader, p2, data, lc, response);
+            }
+            if (lc != 0x04 || !sim_type2_write_page(reader, p2, data)) {
+                return sim_status(response, 0, 0x63, 0x00);
+            }
+            return sim_status(response, 0, 0x90, 0x00);
+
+        case 0xB1: // read value block
+            *rf = TRUE;
+            if (!info->isClassic) {
+                return sim_status(response, 0, 0x63, 0x00);
+            }
+            return sim_classic_read_value(reader, p2, lc, response);
+
+        case 0xD7: // value block operation / restore value block
+            *rf = TRUE;
+            if (!info->isClassic || dataLength != lc) {
+                return sim_status(response, 0, 0x63, 0x00);
+            }
+            return sim_classic_value_operation(reader, p2, data, lc, response);
+
+        case 0x00: // direct transmit to the PN532
+            if (p1 != 0x00 || p2 != 0x00 || dataLength != lc || lc < 2 || data[0] != 0xd4) {
+                return sim_status(response, 0, 0x63, 0x00);
+            }
+            *rf = TRUE;
+            if (data[1] == 0x4a && lc == 0x04 && data[2] == 0x01 && data[3] == 0x00) {
+                return sim_in_list_passive_target(reader, response);
+            }
+            if (data[1] != 0x42) {
+                return sim_status(response, 0, 0x63, 0x00);
+            }
+            return sim_in_communicate_thru(reader, data + 2, dataLength - 2, response);
+
+        default:
+            return sim_status(response, 0, 0x6A, 0x81);
+    }
+}
+
+static LONG sim_transmit(SCARDHANDLE hCard, const BYTE *pbSendBuffer, DWORD dwSendLength, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize) {
+    SimReader *reader = sim_lookup(hCard);
+    if (reader == NULL) {
+        return SCARD_E_INVALID_HANDLE;
+    }
+    if (!reader->tagPresent) {
+        return SCARD_W_REMOVED_CARD;
+    }
+
+    BYTE response[SIM_FRAME_SIZE];
+    BOOL rf = FALSE;
+    BOOL auth = FALSE;
+    DWORD responseLength = sim_handle_apdu(reader, pbSendBuffer, dwSendLength, response, &rf, &auth);
+    if (responseLength > *pbRecvBufferSize) {
+        return SCARD_E_INSUFFICIENT_BUFFER;
+    }
+
+    memcpy(pbRecvBuffer, response, responseLength);
+    *pbRecvBufferSize = responseLength;
+    sim_account(reader, dwSendLength + responseLength, rf, auth);
+
+    return SCARD_S_SUCCESS;
+}
+
+static LONG sim_control(SCARDHANDLE hCard, DWORD dwControlCode, const BYTE *pbSendBuffer, DWORD dwSendLength, BYTE *pbRecvBuffer, DWORD dwRecvBufferSize, DWORD *lpBytesReturned) {
+    (void)dwControlCode;
+
+    SimReader *reader = sim_lookup(hCard);
+    if (reader == NULL) {
+        return SCARD_E_INVALID_HANDLE;
+    }
+
+    static const BYTE firmwareVersion[] = { 'A', 'C', 'R', '1', '2', '2', 'U', '2', '1', '5' };
+    BYTE response[16];
+    DWORD responseLength;
+
+    if (dwSendLength == 5 && pbSendBuffer[0] == 0xFF && pbSendBuffer[1] == 0x00 && pbSendBuffer[2] == 0x52) {
+        responseLength = sim_status(response, 0, 0x90, 0x00);   // set buzzer output during card detection
+    } else if (dwSendLength == 5 && pbSendBuffer[0] == 0xFF && pbSendBuffer[1] == 0x00 && pbSendBuffer[2] == 0x48) {
+        memcpy(response, firmwareVersion, sizeof(firmwareVersion)); // get firmware version (no status bytes)
+        responseLength = sizeof(firmwareVersion);
+    } else {
+        responseLength = sim_status(response, 0, 0x63, 0x00);
+    }
+
+    if (responseLength > dwRecvBufferSize) {
+        return SCARD_E_INSUFFICIENT_BUFFER;
+    }
+    memcpy(pbRecvBuffer, response, responseLength);
+    *lpBytesReturned = responseLength;
+    sim_account(reader, dwSendLength + responseLength, FALSE, FALSE);
+
+    return SCARD_S_SUCCESS;
+}
+
+// sim_lock_cost accounts for one explicit Begin/EndTransaction call (it costs a lock, but saves one per APDU in between)
+static void sim_lock_cost(SimReader *reader) {
+    reader->elapsed_us += reader->latency.lock_us;
+    if (reader->latency.realtime) {
+        sim_sleep_us(reader->latency.lock_us);
+    }
+}
+
+static LONG sim_begin_transaction(SCARDHANDLE hCard) {
+    SimReader *reader = sim_lookup(hCard);
+    if (reader == NULL) {
+        return SCARD_E_INVALID_HANDLE;
+    }
+    if (reader->inTransaction) {
+        return SCARD_E_SHARING_VIOLATION; // pcsc-lite does not nest transactions either
+    }
+
+    reader->inTransaction = TRUE;
+    reader->transactionCount++;
+    sim_lock_cost(reader);
+    return SCARD_S_SUCCESS;
+}
+
+static LONG sim_end_transaction(SCARDHANDLE hCard) {
+    SimReader *reader = sim_lookup(hCard);
+    if (reader == NULL) {
+        return SCARD_E_INVALID_HANDLE;
+    }
+    if (!reader->inTransaction) {
+        return SCARD_E_NOT_TRANSACTED;
+    }
+
+    reader->inTransaction = FALSE;
+    sim_lock_cost(reader);
+    return SCARD_S_SUCCESS;
+}
+
+const Transport SIMULATOR_TRANSPORT = {
+    .name = "simulator",
+    .transmit = sim_transmit,
+    .control = sim_control,
+    .beginTransaction = sim_begin_transaction,
+    .endTransaction = sim_end_transaction,
+};
+
+// -------------------- Public API -------------------------------
+
+// sim_reader_init prepares an empty simulated reader (no tag present), pass NULL as latency for a reader that costs nothing
+void sim_reader_init(SimReader *reader, const SimLatencyModel *latency) {
+    memset(reader, 0, sizeof(*reader));
+    reader->latency = (latency != NULL) ? *latency : SIM_LATENCY_NONE;
+    reader->authenticatedSector = -1;
+}
+
+// sim_insert_tag places a factory fresh tag of the given type on the reader, serial is used to derive its UID
+void sim_insert_tag(SimReader *reader, SimTagType type, uint32_t serial) {
+    const SimTagInfo *info = &SIM_TAG_INFO[type];
+
+    reader->type = type;
+    reader->tagPresent = TRUE;
+    reader->memorySize = info->memorySize;
+    reader->authenticatedSector = -1;
+    reader->passwordAuthenticated = FALSE;
+    reader->halted = FALSE;
+    memset(reader->memory, 0x00, sizeof(reader->memory));
+    memset(reader->counters, 0x00, sizeof(reader->counters));
+
+    if (info->isClassic) {
+        // 4 byte NUID, block 0 holds UID + BCC + SAK + ATQA + manufacturer data
+        reader->uidLength = 4;
+        reader->uid[0] = (serial >> 24) & 0xFF;
+        reader->uid[1] = (serial >> 16) & 0xFF;
+        reader->uid[2] = (serial >> 8) & 0xFF;
+        reader->uid[3] = serial & 0xFF;
+
+        memcpy(reader->memory, reader->uid, 4);
+        reader->memory[4] = reader->uid[0] ^ reader->uid[1] ^ reader->uid[2] ^ reader->uid[3];
+        reader->memory[5] = info->sak;
+        reader->memory[6] = info->atqa[0];
+        reader->memory[7] = info->atqa[1];
+
+        DWORD blocks = info->memorySize / 16;
+        for (DWORD block = 0; block < blocks; block++) {
+            if (block == sim_classic_trailer_of_sector(sim_classic_sector_of_block(block))) {
+                memcpy(reader->memory + block * 16, SIM_UNINITIALIZED_SECTOR_TRAILER, 16);
+            }
+        }
+        return;
+    }
+
+    // 7 byte UID (NXP manufacturer code 0x04), spread across pages 0-2 together with both check bytes
+    reader->uidLength = 7;
+    reader->uid[0] = 0x04;
+    reader->uid[1] = (serial >> 24) & 0xFF;
+    reader->uid[2] = (serial >> 16) & 0xFF;
+    reader->uid[3] = (serial >> 8) & 0xFF;
+    reader->uid[4] = serial & 0xFF;
+    reader->uid[5] = 0x5A;
+    reader->uid[6] = 0x80;
+
+    BYTE *memory = reader->memory;
+    memcpy(memory, reader->uid, 3);
+    memory[3] = 0x88 ^ reader->uid[0] ^ reader->uid[1] ^ reader->uid[2];
+    memcpy(memory + 4, reader->uid + 3, 4);
+    memory[8] = reader->uid[3] ^ reader->uid[4] ^ reader->uid[5] ^ reader->uid[6];
+    memory[9] = 0x48;
+    memcpy(memory + 12, info->cc, 4);
+
+    // configuration pages at the end of the tag: [dynamic lock (ntag only)], CFG0, CFG1, PWD, PACK
+    if (type == SIM_ULTRALIGHT) {
+        return;
+    }
+    DWORD pages = info->memorySize / 4;
+    static const BYTE cfg0Ntag[4] = { 0x04, 0x00, 0x00, 0xFF };
+    static const BYTE cfg0Ultralight[4] = { 0x00, 0x00, 0x00, 0xFF };
+    static const BYTE cfg1[4] = { 0x00, 0x05, 0x00, 0x00 };
+    static const BYTE dynamicLock[4] = { 0x00, 0x00, 0x00, 0xBD };
+    if (type == SIM_ULTRALIGHT_EV1) {
+        memcpy(memory + (pages - 4) * 4, cfg0Ultralight, 4);
+    } else {
+        memcpy(memory + (pages - 5) * 4, dynamicLock, 4);
+        memcpy(memory + (pages - 4) * 4, cfg0Ntag, 4);
+    }
+    memcpy(memory + (pages - 3) * 4, cfg1, 4);
+    memset(memory + (pages - 2) * 4, 0xFF, 4); // default password FF FF FF FF
+}
+
+// sim_remove_tag takes the tag away from the reader, further APDUs fail with SCARD_W_REMOVED_CARD
+void sim_remove_tag(SimReader *reader) {
+    reader->tagPresent = FALSE;
+    reader->authenticatedSector = -1;
+    reader->passwordAuthenticated = FALSE;
+    reader->halted = FALSE;
+}
+
+void sim_reset_stats(SimReader *reader) {
+    reader->apduCount = 0;
+    reader->transactionCount = 0;
+    reader->elapsed_us = 0;
+}
+
+// sim_connect returns a handle that can be passed to executeApdu (after setTransport(&SIMULATOR_TRANSPORT)), 0 if all slots are taken
+// Note: not thread-safe, connect all simulated readers before handing the handles to other threads
+SCARDHANDLE sim_connect(SimReader *reader) {
+    for (int i = 0; i < SIM_MAX_READERS; i++) {
+        if (simReaders[i] == NULL) {
+            simReaders[i] = reader;
+            return (SCARDHANDLE)(i + 1);
+        }
+    }
+
+    LOG_ERROR("All %d simulated reader slots are in use", SIM_MAX_READERS);
+    return 0;
+}
+
+void sim_disconnect(SCARDHANDLE hCard) {
+    if (sim_lookup(hCard) != NULL) {
+        simReaders[hCard - 1] = NULL;
+    }
+}
+
+const char *sim_tag_name(SimTagType type) {
+    return SIM_TAG_INFO[type].name;
+}
@@ -0,0 +1,84 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#ifndef MAIN_H
+#include "main.h"
+#endif
+
+#ifndef COMMON_H
+#include "common.h"
+#endif
+
+#ifndef TRANSPORT_H
+#include "transport.h"
+#endif
+
+// The simulator emulates an ACR122U (and the PN532 inside of it) with a tag lying on it, entirely in memory.
+// Supported pseudo-APDUs: FF CA (get UID), FF 82 (load key), FF 86 / FF 88 (authenticate), FF B0 (read binary), FF D6 (update binary),
+// FF B1 / FF D7 (read value block, value block operation / restore)
+// FF 00 00 00 xx D4 42 (InCommunicateThru) with READ, FAST_READ, WRITE, READ_CNT, INCR_CNT and GET_VERSION, and FF 00 00 00 04 D4 4A (InListPassiveTarget).
+// A Type 2 tag that refused a command and a mifare classic tag that failed an authentication halt like real ones and only answer again once they
+// were selected again (InListPassiveTarget).
+// Escape commands (SCardControl): FF 00 52 (buzzer) and FF 00 48 (firmware version). SCardBeginTransaction / SCardEndTransaction only affect the latency model.
+// Not emulated: SCardConnect / SCardStatus (ATR), access bits of mifare classic sector trailers (only the keys are checked).
+
+#define SIM_MAX_READERS 16
+#define SIM_MAX_MEMORY 4096 // mifare classic 4k is the largest supported tag
+
+typedef enum SimTagType {
+    SIM_MIFARE_CLASSIC_1K,
+    SIM_MIFARE_CLASSIC_4K,
+    SIM_NTAG_213,
+    SIM_NTAG_215,
+    SIM_NTAG_216,
+    SIM_ULTRALIGHT_EV1, // MF0UL11 (20 pages)
+    SIM_MIFARE_MINI,
+    SIM_ULTRALIGHT,     // MF0ICU1 (16 pages, no GET_VERSION, no password)
+} SimTagType;
+
+// SimLatencyModel describes how long the simulated reader takes per APDU, so that benchmarks can estimate tags per minute
+typedef struct SimLatencyModel {
+    DWORD apdu_us;  // fixed cost of every APDU (USB round trip + ACR122U firmware)
+    DWORD byte_us;  // cost per byte sent or received (the ACR122U talks to its PN532 via a 115200 baud UART)
+    DWORD rf_us;    // extra cost of every APDU that has to talk to the tag over RF
+    DWORD auth_us;  // extra cost of a mifare classic three pass authentication
+    DWORD lock_us;  // pcscd taking + releasing the reader lock: implicitly around every APDU outside of a transaction, once per Begin/EndTransaction call
+    BOOL realtime;  // TRUE: actually sleep for the modelled time, FALSE: only add it to elapsed_us (fast and deterministic)
+} SimLatencyModel;
+
+extern const SimLatencyModel SIM_LATENCY_NONE;
+extern const SimLatencyModel SIM_LATENCY_ACR122U;
+
+// SimReader is one simulated reader and the tag currently lying on it
+typedef struct SimReader {
+    SimLatencyModel latency;
+    BOOL tagPresent;
+    SimTagType type;
+    BYTE uid[7];
+    BYTE uidLength;
+    BYTE memory[SIM_MAX_MEMORY];    // classic: 16 byte blocks, ntag/ultralight: 4 byte pages
+    DWORD memorySize;
+    BYTE counters[3][3];            // 24 bit counters (LSB first)
+    BYTE keys[2][6];                // volatile key slots 0x00 and 0x01 of the reader
+    BOOL keyLoaded[2];
+    int authenticatedSector;        // -1 when no sector is authenticated
+    BOOL passwordAuthenticated;     // ntag / ultralight ev1: PWD_AUTH succeeded, pages from AUTH0 on may be accessed
+    BOOL halted;                    // the tag refused a command and waits to be selected again
+    BOOL inTransaction;
+    // statistics
+    DWORD apduCount;
+    DWORD transactionCount;         // SCardBeginTransaction calls (each one also needs an SCardEndTransaction)
+    uint64_t elapsed_us;            // modelled time spent on the reader
+} SimReader;
+
+extern const Transport SIMULATOR_TRANSPORT;
+
+void sim_reader_init(SimReader *reader, const SimLatencyModel *latency);
+void sim_insert_tag(SimReader *reader, SimTagType type, uint32_t serial);
+void sim_remove_tag(SimReader *reader);
+void sim_reset_stats(SimReader *reader);
+SCARDHANDLE sim_connect(SimReader *reader);
+void sim_disconnect(SCARDHANDLE hCard);
+const char *sim_tag_name(SimTagType type);
+
+#endif
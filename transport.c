@@ -0,0 +1,39 @@
+#include "transport.h"
+
+// pcsc_transmit forwards the APDU to the reader via pcsc (T1 = block transmission, see connectToReader)
+static LONG pcsc_transmit(SCARDHANDLE hCard, const BYTE *pbSendBuffer, DWORD dwSendLength, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize) {
+    return SCardTransmit(hCard, SCARD_PCI_T1, pbSendBuffer, dwSendLength, NULL, pbRecvBuffer, pbRecvBufferSize);
+}
+
+// pcsc_control forwards an escape command to the reader via pcsc
+static LONG pcsc_control(SCARDHANDLE hCard, DWORD dwControlCode, const BYTE *pbSendBuffer, DWORD dwSendLength, BYTE *pbRecvBuffer, DWORD dwRecvBufferSize, DWORD *lpBytesReturned) {
+    return SCardControl(hCard, dwControlCode, pbSendBuffer, dwSendLength, pbRecvBuffer, dwRecvBufferSize, lpBytesReturned);
+}
+
+// pcsc_begin_transaction takes the pcscd reader lock once, so that it is not taken and released around every single SCardTransmit
+static LONG pcsc_begin_transaction(SCARDHANDLE hCard) {
+    return SCardBeginTransaction(hCard);
+}
+
+static LONG pcsc_end_transaction(SCARDHANDLE hCard) {
+    return SCardEndTransaction(hCard, SCARD_LEAVE_CARD);
+}
+
+const Transport PCSC_TRANSPORT = {
+    .name = "pcsc",
+    .transmit = pcsc_transmit,
+    .control = pcsc_control,
+    .beginTransaction = pcsc_begin_transaction,
+    .endTransaction = pcsc_end_transaction,
+};
+
+static const Transport *activeTransport = &PCSC_TRANSPORT;
+
+// setTransport replaces the backend used by executeApdu (pass NULL to go back to pcsc)
+void setTransport(const Transport *transport) {
+    activeTransport = (transport != NULL) ? transport : &PCSC_TRANSPORT;
+}
+
+const Transport *getTransport(void) {
+    return activeTransport;
+}
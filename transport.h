@@ -0,0 +1,28 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#ifndef COMMON_H
+#include "common.h"
+#endif
+
+// Transport is the vtable that sits underneath executeApdu (and the escape commands sent via SCardControl).
+// By default PCSC_TRANSPORT is active, which talks to a real reader through pcsc. Swapping it out (e.g. for SIMULATOR_TRANSPORT in simulator.c)
+// lets every driver run unchanged without a physical reader on the bench.
+typedef struct Transport {
+    const char *name;
+    // transmit sends an APDU to the tag. on success *pbRecvBufferSize is set to the amount of bytes that were received (same contract as SCardTransmit)
+    LONG (*transmit)(SCARDHANDLE hCard, const BYTE *pbSendBuffer, DWORD dwSendLength, BYTE *pbRecvBuffer, DWORD *pbRecvBufferSize);
+    // control sends an escape command to the reader itself (same contract as SCardControl)
+    LONG (*control)(SCARDHANDLE hCard, DWORD dwControlCode, const BYTE *pbSendBuffer, DWORD dwSendLength, BYTE *pbRecvBuffer, DWORD dwRecvBufferSize, DWORD *lpBytesReturned);
+    // beginTransaction / endTransaction give this handle exclusive access to the reader until the transaction ends
+    // (same contract as SCardBeginTransaction / SCardEndTransaction with SCARD_LEAVE_CARD)
+    LONG (*beginTransaction)(SCARDHANDLE hCard);
+    LONG (*endTransaction)(SCARDHANDLE hCard);
+} Transport;
+
+extern const Transport PCSC_TRANSPORT;
+
+void setTransport(const Transport *transport);
+const Transport *getTransport(void);
+
+#endif
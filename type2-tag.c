@@ -0,0 +1,735 @@
+#include "type2-tag.h"
+#include "logging.c"
+#include "main.h"
+
+// MODELS
+//      name                        GET_VERSION                             pages   last user   dyn. lock   pages/bit   CFG0    FAST_READ
+const Type2TagModel TYPE2_MODEL_ULTRALIGHT =      { "Mifare Ultralight",     {0},                                    16,     0x0F,       0x00,       0,          0x00,   FALSE };   // no GET_VERSION
+const Type2TagModel TYPE2_MODEL_ULTRALIGHT_C =    { "Mifare Ultralight C",   {0},                                    44,     0x27,       0x28,       4,          0x00,   FALSE };   // no GET_VERSION, the 3DES key (0x2C - 0x2F) can not be read
+const Type2TagModel TYPE2_MODEL_ULTRALIGHT_EV1 =  { "Mifare Ultralight EV1", { 0x04, 0x03, 0x01, 0x01, 0x00, 0x0B }, 20,     0x0F,       0x00,       0,          0x10,   TRUE };
+const Type2TagModel TYPE2_MODEL_NTAG_213 =        { "NTAG 213",              { 0x04, 0x04, 0x02, 0x01, 0x00, 0x0F }, 45,     0x27,       0x28,       2,          0x29,   TRUE };
+const Type2TagModel TYPE2_MODEL_NTAG_215 =        { "NTAG 215",              { 0x04, 0x04, 0x02, 0x01, 0x00, 0x11 }, 135,    0x81,       0x82,       16,         0x83,   TRUE };
+const Type2TagModel TYPE2_MODEL_NTAG_216 =        { "NTAG 216",              { 0x04, 0x04, 0x02, 0x01, 0x00, 0x13 }, 231,    0xE1,       0xE2,       16,         0xE3,   TRUE };
+
+static const Type2TagModel TYPE2_MODEL_ULTRALIGHT_EV1_H11 =  { "Mifare Ultralight EV1",          { 0x04, 0x03, 0x02, 0x01, 0x00, 0x0B }, 20, 0x0F, 0x00, 0,  0x10, TRUE }; // MF0ULH11 (17 pF)
+static const Type2TagModel TYPE2_MODEL_ULTRALIGHT_EV1_21 =   { "Mifare Ultralight EV1 (MF0UL21)", { 0x04, 0x03, 0x01, 0x01, 0x00, 0x0E }, 41, 0x23, 0x24, 4,  0x25, TRUE };
+static const Type2TagModel TYPE2_MODEL_ULTRALIGHT_EV1_H21 =  { "Mifare Ultralight EV1 (MF0UL21)", { 0x04, 0x03, 0x02, 0x01, 0x00, 0x0E }, 41, 0x23, 0x24, 4,  0x25, TRUE }; // MF0ULH21 (17 pF)
+static const Type2TagModel TYPE2_MODEL_NTAG_210 =            { "NTAG 210",                        { 0x04, 0x04, 0x01, 0x01, 0x00, 0x0B }, 20, 0x0F, 0x00, 0,  0x10, TRUE };
+static const Type2TagModel TYPE2_MODEL_NTAG_212 =            { "NTAG 212",                        { 0x04, 0x04, 0x01, 0x01, 0x00, 0x0E }, 41, 0x23, 0x24, 2,  0x25, TRUE };
+
+static const Type2TagModel *TYPE2_MODELS[] = {
+    &TYPE2_MODEL_ULTRALIGHT, &TYPE2_MODEL_ULTRALIGHT_C, &TYPE2_MODEL_ULTRALIGHT_EV1, &TYPE2_MODEL_ULTRALIGHT_EV1_H11, &TYPE2_MODEL_ULTRALIGHT_EV1_21, &TYPE2_MODEL_ULTRALIGHT_EV1_H21,
+    &TYPE2_MODEL_NTAG_210, &TYPE2_MODEL_NTAG_212, &TYPE2_MODEL_NTAG_213, &TYPE2_MODEL_NTAG_215, &TYPE2_MODEL_NTAG_216,
+};
+
+// FAST_READ answers with d5 43 00 + pages + 90 00 and all of it has to fit into one PN532 frame: (256 - 3 - 2) / 4 = 62 pages
+#define MAX_PAGES_PER_FAST_READ ((ACR_SESSION_RECV_BUFFER_SIZE - 3 - 2) / TYPE2_PAGE_SIZE)
+
+// -------------------------------- models ---------------------------------
+
+// type2_model_of_tag maps a tag name (see acr_session_tag_name) to its model, NULL: not a (detected) Type 2 tag
+const Type2TagModel *type2_model_of_tag(const char *tagName) {
+    for (size_t i = 0; i < sizeof(TYPE2_MODELS) / sizeof(TYPE2_MODELS[0]); i++) {
+        if (strcmp(tagName, TYPE2_MODELS[i]->name) == 0) {
+            return TYPE2_MODELS[i];
+        }
+    }
+    return NULL;
+}
+
+// type2_model_of_version looks up the 8 bytes of a GET_VERSION response (the protocol type in the last byte is the same for all of them), NULL: unknown tag
+const Type2TagModel *type2_model_of_version(const BYTE *version) {
+    for (size_t i = 0; i < sizeof(TYPE2_MODELS) / sizeof(TYPE2_MODELS[0]); i++) {
+        if ((TYPE2_MODELS[i]->version[0] != 0x00) && (memcmp(version + 1, TYPE2_MODELS[i]->version, 6) == 0)) {
+            return TYPE2_MODELS[i];
+        }
+    }
+    return NULL;
+}
+
+// type2_tag_refused tells whether the reader got through to the tag and the tag refused the command (NAK): d5 43 <error> 90 00.
+// such a tag halts and has to be selected again (reselectTag)
+static BOOL type2_tag_refused(ApduResponse response, const BYTE *pbRecvBuffer) {
+    return isSuccessResponse(response, pbRecvBuffer, 3) && (pbRecvBuffer[0] == 0xd5) && (pbRecvBuffer[1] == 0x43) && (pbRecvBuffer[2] != PN532_STATUS_OK);
+}
+
+// type2_send_get_version sends GET_VERSION and copies its 8 bytes into version, *refused: the tag answered with a NAK (see type2_tag_refused)
+static BOOL type2_send_get_version(BYTE *version, BOOL *refused, acr_session *session) {
+    BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
+
+    // ff 00 00 00 03 (communicate with pn532 and 3 byte command will follow)
+    //      d4 (data exchange command)
+    //      42 (InCommunicateThru)
+    //      60 (GET_VERSION) [page 34 of ntag21x document, page 16 of MF0ULX1 document]
+    // Response:
+    //      d5 43 00
+    //      00 (header) 04 (NXP) product type, subtype, major and minor product version, storage size, protocol type
+    //      90 00
+    BYTE APDU_GetVersion[8] = { 0xff, 0x00, 0x00, 0x00, 0x03, 0xd4, 0x42, 0x60 };
+    ApduResponse response = executeApdu(session, APDU_GetVersion, sizeof(APDU_GetVersion));
+    *refused = type2_tag_refused(response, pbRecvBuffer);
+    if (!isTagSuccessResponse(response, pbRecvBuffer, 3 + 8)) {
+        LOG_INFO("The tag does not answer GET_VERSION.");
+        return FALSE;
+    }
+    memcpy(version, pbRecvBuffer + 3, 8);
+    return TRUE;
+}
+
+// type2_get_version sends GET_VERSION and copies its 8 bytes into version (a tag that refuses it has to be selected again, see reselectTag)
+BOOL type2_get_version(BYTE *version, acr_session *session) {
+    BOOL refused;
+    return type2_send_get_version(version, &refused, session);
+}
+
+// type2_detect_ultralight tells a plain Ultralight (16 pages) from an Ultralight C (48 pages), neither of which answers GET_VERSION:
+// only the Ultralight C has a page 0x10, a plain Ultralight refuses to read it (and has to be selected again). NULL: the tag did not answer
+static const Type2TagModel *type2_detect_ultralight(acr_session *session) {
+    BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
+
+    BYTE APDU_Read[9] = { 0xff, 0x00, 0x00, 0x00, 0x04, 0xd4, 0x42, 0x30, 0x10 };
+    ApduResponse response = executeApdu(session, APDU_Read, sizeof(APDU_Read));
+    if (isTagSuccessResponse(response, pbRecvBuffer, 3 + 4 * TYPE2_PAGE_SIZE)) {
+        return &TYPE2_MODEL_ULTRALIGHT_C;
+    }
+    if (type2_tag_refused(response, pbRecvBuffer) && reselectTag(session)) {
+        return &TYPE2_MODEL_ULTRALIGHT;
+    }
+    return NULL;
+}
+
+// type2_detect returns the model of the Type 2 tag on the reader, NULL: unknown tag (or it did not answer, try again). GET_VERSION is sent once per tag,
+// the model is remembered as the tag name of the session (forgotten by acr_session_tag_changed). a tag that getStatus named TYPE2_TAG_NAME_UNDETERMINED
+// and that refuses GET_VERSION (NAK) is selected again and is a Mifare Ultralight or Ultralight C (see type2_detect_ultralight)
+const Type2TagModel *type2_detect(acr_session *session) {
+    const char *tagName = acr_session_tag_name(session);
+    const Type2TagModel *model = type2_model_of_tag(tagName);
+    if (model != NULL) {
+        return model;
+    }
+
+    BYTE version[8];
+    BOOL refused;
+    if (type2_send_get_version(version, &refused, session)) {
+        model = type2_model_of_version(version);
+        if (model == NULL) {
+            LOG_WARN("Unknown Type 2 tag, GET_VERSION: %02x %02x %02x %02x %02x %02x %02x %02x",
+                version[0], version[1], version[2], version[3], version[4], version[5], version[6], version[7]);
+            return NULL;
+        }
+    } else if (!refused) {
+        return NULL; // no answer at all, nothing is cached so that the next call asks again
+    } else if (!reselectTag(session) || (strcmp(tagName, TYPE2_TAG_NAME_UNDETERMINED) != 0)) {
+        return NULL;
+    } else {
+        model = type2_detect_ultralight(session);
+        if (model == NULL) {
+            return NULL;
+        }
+    }
+
+    LOG_INFO("Identified tag as: %s", model->name);
+    acr_session_set_tag_name(session, model->name);
+    return model;
+}
+
+// -------------------------------- read / write tag ---------------------------------
+
+// type2_read_chunks reads pages fromPage - toPage with FAST_READ if the tag has it and hands every exchange to onPages right out of the receive buffer
+static BOOL type2_read_chunks(const Type2TagModel *model, BYTE fromPage, BYTE toPage, Type2PageCallback onPages, void *arg, acr_session *session) {
+    BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
+
+    // Main problem: Fast reading entire tag with 256 Bytes buffer is NOT possible at once, e.g. for NTAG 216: 231*4 + 3 ("d5 43 00") + 2 ("90 00") = 929 > 256,
+    //               it is a limitation of pn532 (reader inside of acr122u), so we might have to split the fast read into several parts
+    int currentPage = fromPage; // not BYTE: toPage might be 0xFF
+    while (currentPage <= toPage) {
+        BYTE readStart = (BYTE)currentPage;
+        int remainingPages = toPage - currentPage + 1;
+
+        if (!model->fastRead) {
+            // 30 (Read) returns 4 pages, rolling over to page 0x00 at the end of the tag
+            BYTE APDU_Read[9] = { 0xff, 0x00, 0x00, 0x00, 0x04, 0xd4, 0x42, 0x30, readStart };
+            ApduResponse response = executeApdu(session, APDU_Read, sizeof(APDU_Read));
+            if (!isTagSuccessResponse(response, pbRecvBuffer, 3 + 4 * TYPE2_PAGE_SIZE)) {
+                LOG_ERROR("Reading page 0x%02x failed.", readStart);
+                return FALSE;
+            }
+            int pagesRead = (remainingPages > 4) ? 4 : remainingPages;
+            if (!onPages(readStart, (BYTE)pagesRead, pbRecvBuffer + 3, arg)) {
+                LOG_DEBUG("Reading stopped by the callback after page 0x%02x.", readStart + pagesRead - 1);
+                return FALSE;
+            }
+            currentPage += pagesRead;
+            continue;
+        }
+
+        // as few exchanges as the frame allows, split evenly (NTAG 216: 4 x 58 instead of 62 + 62 + 62 + 45, NTAG 215: 3 x 45)
+        int exchangesLeft = (remainingPages + MAX_PAGES_PER_FAST_READ - 1) / MAX_PAGES_PER_FAST_READ;
+        int pagesToRead = (remainingPages + exchangesLeft - 1) / exchangesLeft;
+        BYTE readEnd = (BYTE)(currentPage + pagesToRead - 1);
+
+        // ff 00 00 00 05 (communicate with pn532 and 05 byte command will follow)
+        //      d4 (data exchange command)
+        //      42 (InCommunicateThru)
+        //      3a (FastRead) [page 39 of ntag21x document]
+        //      read from page
+        //      read to page
+        // Response:
+        //      d5 43 00
+        //      all bytes read
+        //      90 00
+        BYTE APDU_Read[10] = { 0xff, 0x00, 0x00, 0x00, 0x05, 0xd4, 0x42, 0x3a, readStart, readEnd };
+        ApduResponse response = executeApdu(session, APDU_Read, sizeof(APDU_Read));
+        if (!isTagSuccessResponse(response, pbRecvBuffer, 3 + pagesToRead * TYPE2_PAGE_SIZE)) {
+            LOG_ERROR("Fast read from page 0x%02x to 0x%02x failed.", readStart, readEnd);
+            return FALSE;
+        }
+        if (!onPages(readStart, (BYTE)pagesToRead, pbRecvBuffer + 3, arg)) {
+            LOG_DEBUG("Reading stopped by the callback after page 0x%02x.", readEnd);
+            return FALSE;
+        }
+        currentPage += pagesToRead;
+    }
+
+    return TRUE;
+}
+
+// Type2PageBuffer is where type2_copy_pages puts the pages of type2_read_pages
+typedef struct Type2PageBuffer {
+    BYTE *pages;                // pages[0] is fromPage
+    BYTE fromPage;
+} Type2PageBuffer;
+
+static BOOL type2_copy_pages(BYTE firstPage, BYTE amountPages, const BYTE *data, void *arg) {
+    Type2PageBuffer *buffer = (Type2PageBuffer *)arg;
+    memcpy(buffer->pages + (firstPage - buffer->fromPage) * TYPE2_PAGE_SIZE, data, (size_t)amountPages * TYPE2_PAGE_SIZE);
+    return TRUE;
+}
+
+static BOOL type2_print_chunk(BYTE firstPage, BYTE amountPages, const BYTE *data, void *arg) {
+    (void)arg;
+    type2_print_pages(firstPage, (BYTE)(firstPage + amountPages - 1), data);
+    return TRUE;
+}
+
+// type2_check_range makes sure fromPage - toPage is a valid range of pages of the tag
+static BOOL type2_check_range(const Type2TagModel *model, BYTE fromPage, BYTE toPage) {
+    if ((fromPage > toPage) || (toPage >= model->amountPages)) {
+        LOG_WARN("The pages 0x%02x - 0x%02x you provided are not valid! Must be in [0x00, 0x%02x] and in ascending order", fromPage, toPage, model->amountPages - 1);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// type2_read_pages copies pages fromPage - toPage into the caller's buffer (4 bytes per page, pages[0] is fromPage, capacity in bytes), nothing is printed
+static BOOL do_type2_read_pages(const Type2TagModel *model, BYTE fromPage, BYTE toPage, BYTE *pages, size_t capacity, acr_session *session) {
+    if (!type2_check_range(model, fromPage, toPage)) {
+        return FALSE;
+    }
+    if (capacity < (size_t)(toPage - fromPage + 1) * TYPE2_PAGE_SIZE) {
+        LOG_WARN("A buffer of %zu bytes can not hold pages 0x%02x - 0x%02x (%d bytes).", capacity, fromPage, toPage, (toPage - fromPage + 1) * TYPE2_PAGE_SIZE);
+        return FALSE;
+    }
+
+    Type2PageBuffer buffer = { pages, fromPage };
+    return type2_read_chunks(model, fromPage, toPage, type2_copy_pages, &buffer, session);
+}
+
+BOOL type2_read_pages(const Type2TagModel *model, BYTE fromPage, BYTE toPage, BYTE *pages, size_t capacity, acr_session *session) {
+    return ACR_SESSION_OPERATION(session, do_type2_read_pages(model, fromPage, toPage, pages, capacity, session));
+}
+
+// type2_read_pages_with streams pages fromPage - toPage to onPages as the exchanges arrive (see Type2PageCallback), nothing is buffered or printed
+static BOOL do_type2_read_pages_with(const Type2TagModel *model, BYTE fromPage, BYTE toPage, Type2PageCallback onPages, void *arg, acr_session *session) {
+    if (!type2_check_range(model, fromPage, toPage)) {
+        return FALSE;
+    }
+    return type2_read_chunks(model, fromPage, toPage, onPages, arg, session);
+}
+
+BOOL type2_read_pages_with(const Type2TagModel *model, BYTE fromPage, BYTE toPage, Type2PageCallback onPages, void *arg, acr_session *session) {
+    return ACR_SESSION_OPERATION(session, do_type2_read_pages_with(model, fromPage, toPage, onPages, arg, session));
+}
+
+// type2_read_page reads the provided page and the 3 pages after it (READ always returns 4 pages, rolling over at the end of the tag) and prints them
+static BOOL do_type2_read_page(const Type2TagModel *model, BYTE page, acr_session *session) {
+    BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
+    if (page >= model->amountPages) {
+        LOG_WARN("page 0x%02x you provided is not valid! Must be in [0x00, 0x%02x]", page, model->amountPages - 1);
+        return FALSE;
+    }
+
+    BYTE APDU_Read[9] = { 0xff, 0x00, 0x00, 0x00, 0x04, 0xd4, 0x42, 0x30, page };
+    ApduResponse response = executeApdu(session, APDU_Read, sizeof(APDU_Read));
+    if (!isTagSuccessResponse(response, pbRecvBuffer, 3 + 4 * TYPE2_PAGE_SIZE)) {
+        LOG_ERROR("Reading page 0x%02x failed.", page);
+        return FALSE;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        type2_print_pages((BYTE)((page + i) % model->amountPages), (BYTE)((page + i) % model->amountPages), pbRecvBuffer + 3 + i * TYPE2_PAGE_SIZE);
+    }
+    return TRUE;
+}
+
+BOOL type2_read_page(const Type2TagModel *model, BYTE page, acr_session *session) {
+    return ACR_SESSION_OPERATION(session, do_type2_read_page(model, page, session));
+}
+
+// type2_fast_read reads all data between 'fromPage' and 'toPage' and prints it
+static BOOL do_type2_fast_read(const Type2TagModel *model, BYTE fromPage, BYTE toPage, acr_session *session) {
+    LOG_DEBUG("Trying to fast read from page 0x%02x to page 0x%02x.", fromPage, toPage);
+    // sanity checks
+    //      both pages are in valid range
+    if ((fromPage >= model->amountPages) || (toPage >= model->amountPages)) {
+        LOG_WARN("The pages 0x%02x - 0x%02x you provided are not valid! Must be in [0x00, 0x%02x]", fromPage, toPage, model->amountPages - 1);
+        return FALSE;
+    }
+    //      swap the two pages if necessary
+    if (fromPage > toPage) {
+        BYTE tmp = toPage;
+        toPage = fromPage;
+        fromPage = tmp;
+        LOG_DEBUG("Swapped fromPage and toPage");
+    }
+
+    // print only the read pages in human-readable form (as in nicely formatted hex), one exchange at a time
+    return type2_read_chunks(model, fromPage, toPage, type2_print_chunk, NULL, session);
+}
+
+BOOL type2_fast_read(const Type2TagModel *model, BYTE fromPage, BYTE toPage, acr_session *session) {
+    return ACR_SESSION_OPERATION(session, do_type2_fast_read(model, fromPage, toPage, session));
+}
+
+// type2_write writes 4 bytes to any page, without checking what that page is
+static BOOL type2_write(const BYTE *data, BYTE page, acr_session *session) {
+    BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
+
+    // ff 00 00 00 08 (communicate with pn532 and 8 byte (4 byte command and 4 byte data) command will follow)
+    //      d4 (data exchange command)
+    //      42 (InCommunicateThru)
+    //      a2 (Write) [page 41 of ntag21x document]
+    //      page (which page you target)
+    //      4 bytes you want to write
+    BYTE APDU_Write[9 + 4] = { 0xff, 0x00, 0x00, 0x00, 0x08, 0xd4, 0x42, 0xa2, page };
+    memcpy(APDU_Write + 9, data, 4);
+
+    // write to page
+    ApduResponse response = executeApdu(session, APDU_Write, sizeof(APDU_Write));
+    if (!isTagSuccessResponse(response, pbRecvBuffer, 3)) {
+        LOG_ERROR("Failed to write to page 0x%02x. Aborting..", page);
+        return FALSE;
+    }
+    LOG_INFO("Wrote data to page 0x%02x with success.", page);
+
+    return TRUE;
+}
+
+// type2_write_page writes 4 bytes to a page, but only if that page is user memory (safe)
+BOOL type2_write_page(const Type2TagModel *model, const BYTE *data, BYTE page, acr_session *session) {
+    LOG_DEBUG("Trying to write to page 0x%02x.", page);
+    // sanity check
+    if ((page < 0x04) || (page > model->lastUserPage)) {
+        LOG_WARN("Page 0x%02x is not a user memory page of a %s (0x04 - 0x%02x). Refusing to write there.", page, model->name, model->lastUserPage);
+        return FALSE;
+    }
+
+    return type2_write(data, page, session);
+}
+
+// type2_reset_user_data writes zeroes to every user memory page (0x04 - lastUserPage)
+static BOOL do_type2_reset_user_data(const Type2TagModel *model, acr_session *session) {
+    LOG_DEBUG("Trying to reset all user data pages to zeroes.");
+    BYTE Zeroes[4] = {0};
+    for (int page = 0x04; page <= model->lastUserPage; page++) {
+        if (!type2_write_page(model, Zeroes, (BYTE)page, session)) {
+            LOG_ERROR("An error occurred, aborting..");
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+BOOL type2_reset_user_data(const Type2TagModel *model, acr_session *session) {
+    return ACR_SESSION_OPERATION(session, do_type2_reset_user_data(model, session));
+}
+
+// type2_write_changed_pages makes pages fromPage - toPage (user memory only) look like target ((toPage - fromPage + 1) * 4 bytes): the range is read first
+// in as few FAST_READs as possible and only pages with a different content are written. if the range can not be read (e.g. read protected), nothing is written
+static BOOL do_type2_write_changed_pages(const Type2TagModel *model, const BYTE *target, BYTE fromPage, BYTE toPage, acr_session *session) {
+    // check the whole range up front, so that it is never written only partially
+    if (!type2_check_range(model, fromPage, toPage)) {
+        return FALSE;
+    }
+    if ((fromPage < 0x04) || (toPage > model->lastUserPage)) {
+        LOG_WARN("Pages 0x%02x - 0x%02x are not all user memory pages of a %s (0x04 - 0x%02x). Refusing to write there.", fromPage, toPage, model->name, model->lastUserPage);
+        return FALSE;
+    }
+
+    BYTE current[TYPE2_MAX_PAGES * TYPE2_PAGE_SIZE];
+    Type2PageBuffer buffer = { current, fromPage };
+    if (!type2_read_chunks(model, fromPage, toPage, type2_copy_pages, &buffer, session)) {
+        LOG_ERROR("Could not read pages 0x%02x - 0x%02x (read protected? see type2_authenticate), so the changed ones are unknown. Aborting..", fromPage, toPage);
+        return FALSE;
+    }
+
+    int written = 0;
+    for (int page = fromPage; page <= toPage; page++) {
+        const BYTE *wanted = target + (page - fromPage) * TYPE2_PAGE_SIZE;
+        if (memcmp(wanted, current + (page - fromPage) * TYPE2_PAGE_SIZE, TYPE2_PAGE_SIZE) == 0) {
+            continue;
+        }
+        if (!type2_write_page(model, wanted, (BYTE)page, session)) {
+            LOG_ERROR("An error occurred, aborting..");
+            return FALSE;
+        }
+        written++;
+    }
+    LOG_INFO("Wrote %d of %d pages, the others already had the wanted content.", written, toPage - fromPage + 1);
+
+    return TRUE;
+}
+
+BOOL type2_write_changed_pages(const Type2TagModel *model, const BYTE *target, BYTE fromPage, BYTE toPage, acr_session *session) {
+    return ACR_SESSION_OPERATION(session, do_type2_write_changed_pages(model, target, fromPage, toPage, session));
+}
+
+// type2_reset_changed_user_data is type2_reset_user_data that only writes the user memory pages that are not zeroes yet (a blank tag costs only the reads)
+BOOL type2_reset_changed_user_data(const Type2TagModel *model, acr_session *session) {
+    static const BYTE Zeroes[TYPE2_MAX_PAGES * TYPE2_PAGE_SIZE] = {0};
+    return ACR_SESSION_OPERATION(session, do_type2_write_changed_pages(model, Zeroes, 0x04, model->lastUserPage, session));
+}
+
+// -------------------------------- full image ---------------------------------
+
+#define TYPE2_CFGLCK 0x40   // bit 6 of the first byte of CFG1 (ACCESS): CFG0 and CFG1 can never be written again
+#define TYPE2_PROT 0x80     // bit 7 of the first byte of CFG1 (ACCESS): pages from AUTH0 on also need the password to be read
+
+// Type2PlannedWrite is one WRITE of type2_write_image, all of them are known (and checked) before the first one is sent
+typedef struct Type2PlannedWrite {
+    BYTE page;
+    BYTE data[TYPE2_PAGE_SIZE];
+} Type2PlannedWrite;
+
+static void type2_plan_write(Type2PlannedWrite *plan, int *planned, int page, const BYTE *data) {
+    plan[*planned].page = (BYTE)page;
+    memcpy(plan[*planned].data, data, TYPE2_PAGE_SIZE);
+    (*planned)++;
+}
+
+// type2_only_sets_bits checks that going from 'from' to 'to' does not clear any bit (capability container and lock bytes are one time programmable)
+static BOOL type2_only_sets_bits(const BYTE *from, const BYTE *to, int length) {
+    for (int i = 0; i < length; i++) {
+        if ((from[i] & to[i]) != from[i]) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// type2_page_locked tells whether the lock bytes (static: page 0x02, dynamic: model->dynamicLockPage) or CFGLCK in image forbid writing page
+static BOOL type2_page_locked(const Type2TagModel *model, const BYTE *image, int page) {
+    const BYTE *staticLock = image + 2 * TYPE2_PAGE_SIZE + 2;
+    if (page == 0x03) {
+        return (staticLock[0] & 0x08) != 0;                             // L CC
+    }
+    if ((page >= 0x04) && (page <= 0x07)) {
+        return ((staticLock[0] >> page) & 0x01) != 0;                   // L4 - L7 in bits 4 - 7
+    }
+    if ((page >= 0x08) && (page <= 0x0F)) {
+        return ((staticLock[1] >> (page - 0x08)) & 0x01) != 0;          // L8 - L15
+    }
+    if ((model->dynamicLockPage != 0x00) && (page >= 0x10) && (page <= model->lastUserPage)) {
+        const BYTE *dynamicLock = image + model->dynamicLockPage * TYPE2_PAGE_SIZE;
+        int bit = (page - 0x10) / model->dynamicLockPages;
+        return ((dynamicLock[bit / 8] >> (bit % 8)) & 0x01) != 0;
+    }
+    if ((model->configPage != 0x00) && ((page == model->configPage) || (page == model->configPage + 1))) {
+        return (image[(model->configPage + 1) * TYPE2_PAGE_SIZE] & TYPE2_CFGLCK) != 0;
+    }
+    return FALSE;
+}
+
+// type2_lock_bits_frozen tells whether data (the new content of the static or dynamic lock page) sets lock bits that a block-locking bit in current
+// keeps from being set: static lock byte 0 bit 0 freezes L CC, bit 1 freezes L4 - L9 and bit 2 freezes L10 - L15. dynamic lock byte 2 holds the
+// block-locking bits of the dynamic lock bits, whose grouping differs between the models: any of them set is taken to freeze all of them
+static BOOL type2_lock_bits_frozen(const Type2TagModel *model, const BYTE *current, const BYTE *data, int page) {
+    if (page == 0x02) {
+        const BYTE *present = current + 2 * TYPE2_PAGE_SIZE + 2;
+        BYTE set0 = data[2] & ~present[0];
+        BYTE set1 = data[3] & ~present[1];
+        return ((present[0] & 0x01) && (set0 & 0x08)) ||                            // BL CC
+               ((present[0] & 0x02) && ((set0 & 0xF0) || (set1 & 0x03))) ||         // BL 9-4
+               ((present[0] & 0x04) && (set1 & 0xFC));                              // BL 15-10
+    }
+    if ((model->dynamicLockPage != 0x00) && (page == model->dynamicLockPage)) {
+        const BYTE *present = current + model->dynamicLockPage * TYPE2_PAGE_SIZE;
+        return (present[2] != 0x00) && (((data[0] & ~present[0]) != 0) || ((data[1] & ~present[1]) != 0));
+    }
+    return FALSE;
+}
+
+// type2_write_image makes the tag look like target (model->amountPages pages, as type2_read_pages returns them from page 0x00 on) in one operation.
+// current is the content of the tag, NULL: read it first. a supplied current is updated to the new content, so it can be used for the next update right away.
+// Only pages that differ are written, in an order that never locks out a later write:
+//      1. capability container and user memory
+//      2. PWD and PACK (zeroes: keep, both read back as zeroes anyway), then CFG0 / CFG1 with AUTH0 and CFGLCK as they are now
+//      3. dynamic, then static lock bytes
+//      4. AUTH0 (switches on the password protection), then CFGLCK (locks the configuration)
+// The whole plan is checked before the first write: the UID (pages 0x00 - 0x01 and the first two bytes of page 0x02) is never written, one time
+// programmable bits can not be cleared, locked pages can not be written, lock bits frozen by their block-locking bits can not be set and pages
+// protected by AUTH0 can not be written unless the tag is authenticated (type2_authenticate, which is kept across the whole image)
+static BOOL do_type2_write_image(const Type2TagModel *model, const BYTE *target, BYTE *current, acr_session *session) {
+    BYTE readImage[TYPE2_MAX_PAGES * TYPE2_PAGE_SIZE];
+    if (current == NULL) {
+        Type2PageBuffer buffer = { readImage, 0x00 };
+        if (!type2_read_chunks(model, 0x00, (BYTE)(model->amountPages - 1), type2_copy_pages, &buffer, session)) {
+            LOG_ERROR("Could not read the %s, the image can not be checked against it. Aborting..", model->name);
+            return FALSE;
+        }
+        current = readImage;
+    }
+    if (memcmp(target, current, 2 * TYPE2_PAGE_SIZE + 2) != 0) {
+        LOG_DEBUG("The image has a different UID than the tag (taken from another tag?), the UID is left as it is.");
+    }
+
+    Type2PlannedWrite plan[TYPE2_MAX_PAGES + 2];
+    int planned = 0;
+    BYTE data[TYPE2_PAGE_SIZE];
+
+    // 1. capability container and user memory
+    if (memcmp(target + 3 * TYPE2_PAGE_SIZE, current + 3 * TYPE2_PAGE_SIZE, TYPE2_PAGE_SIZE) != 0) {
+        if (!type2_only_sets_bits(current + 3 * TYPE2_PAGE_SIZE, target + 3 * TYPE2_PAGE_SIZE, TYPE2_PAGE_SIZE)) {
+            LOG_ERROR("The capability container (page 0x03) is one time programmable, the image would have to clear bits of it. Aborting..");
+            return FALSE;
+        }
+        type2_plan_write(plan, &planned, 0x03, target + 3 * TYPE2_PAGE_SIZE);
+    }
+    for (int page = 0x04; page <= model->lastUserPage; page++) {
+        if (memcmp(target + page * TYPE2_PAGE_SIZE, current + page * TYPE2_PAGE_SIZE, TYPE2_PAGE_SIZE) != 0) {
+            type2_plan_write(plan, &planned, page, target + page * TYPE2_PAGE_SIZE);
+        }
+    }
+
+    // 2. configuration, without switching on AUTH0 / CFGLCK yet
+    int currentAuth0 = 0x100; // no configuration pages: nothing is protected
+    if (model->configPage != 0x00) {
+        int cfg0 = model->configPage, cfg1 = model->configPage + 1;
+        currentAuth0 = current[cfg0 * TYPE2_PAGE_SIZE + 3];
+        BYTE currentLock = current[cfg1 * TYPE2_PAGE_SIZE] & TYPE2_CFGLCK;
+        if (currentLock && !(target[cfg1 * TYPE2_PAGE_SIZE] & TYPE2_CFGLCK)) {
+            LOG_ERROR("The configuration of the tag is locked (CFGLCK), the image would have to unlock it. Aborting..");
+            return FALSE;
+        }
+
+        for (int page = model->configPage + 2; page <= model->configPage + 3; page++) {
+            static const BYTE Zeroes[TYPE2_PAGE_SIZE] = {0};
+            const BYTE *wanted = target + page * TYPE2_PAGE_SIZE;
+            if ((memcmp(wanted, Zeroes, TYPE2_PAGE_SIZE) != 0) && (memcmp(wanted, current + page * TYPE2_PAGE_SIZE, TYPE2_PAGE_SIZE) != 0)) {
+                type2_plan_write(plan, &planned, page, wanted);
+            }
+        }
+
+        memcpy(data, target + cfg0 * TYPE2_PAGE_SIZE, TYPE2_PAGE_SIZE);
+        data[3] = (BYTE)currentAuth0;
+        if (memcmp(data, current + cfg0 * TYPE2_PAGE_SIZE, TYPE2_PAGE_SIZE) != 0) {
+            type2_plan_write(plan, &planned, cfg0, data);
+        }
+        memcpy(data, target + cfg1 * TYPE2_PAGE_SIZE, TYPE2_PAGE_SIZE);
+        data[0] = (BYTE)((data[0] & ~TYPE2_CFGLCK) | currentLock);
+        if (memcmp(data, current + cfg1 * TYPE2_PAGE_SIZE, TYPE2_PAGE_SIZE) != 0) {
+            type2_plan_write(plan, &planned, cfg1, data);
+        }
+    }
+
+    // 3. lock bytes, after all the pages they might lock
+    if (model->dynamicLockPage != 0x00) {
+        const BYTE *present = current + model->dynamicLockPage * TYPE2_PAGE_SIZE;
+        memcpy(data, target + model->dynamicLockPage * TYPE2_PAGE_SIZE, 3);
+        data[3] = present[3]; // RFUI
+        if (memcmp(data, present, TYPE2_PAGE_SIZE) != 0) {
+            if (!type2_only_sets_bits(present, data, 3)) {
+                LOG_ERROR("Lock bits can not be cleared, the dynamic lock bytes of the image lack some that are set. Aborting..");
+                return FALSE;
+            }
+            type2_plan_write(plan, &planned, model->dynamicLockPage, data);
+        }
+    }
+    memcpy(data, current + 2 * TYPE2_PAGE_SIZE, 2); // UID / internal, ignored by the tag
+    memcpy(data + 2, target + 2 * TYPE2_PAGE_SIZE + 2, 2);
+    if (memcmp(data, current + 2 * TYPE2_PAGE_SIZE, TYPE2_PAGE_SIZE) != 0) {
+        if (!type2_only_sets_bits(current + 2 * TYPE2_PAGE_SIZE + 2, data + 2, 2)) {
+            LOG_ERROR("Lock bits can not be cleared, the static lock bytes of the image lack some that are set. Aborting..");
+            return FALSE;
+        }
+        type2_plan_write(plan, &planned, 0x02, data);
+    }
+
+    // 4. AUTH0, then CFGLCK: from here on the tag might refuse writes without a password
+    if (model->configPage != 0x00) {
+        int cfg0 = model->configPage, cfg1 = model->configPage + 1;
+        int targetAuth0 = target[cfg0 * TYPE2_PAGE_SIZE + 3];
+        if (targetAuth0 != currentAuth0) {
+            type2_plan_write(plan, &planned, cfg0, target + cfg0 * TYPE2_PAGE_SIZE);
+        }
+        if ((target[cfg1 * TYPE2_PAGE_SIZE] & TYPE2_CFGLCK) && !(current[cfg1 * TYPE2_PAGE_SIZE] & TYPE2_CFGLCK)) {
+            if ((targetAuth0 != currentAuth0) && (targetAuth0 <= cfg1) && !acr_session_is_type2_authenticated(session, NULL)) {
+                LOG_ERROR("AUTH0 0x%02x of the image protects CFG1, so CFGLCK can not be set after it without the password. Aborting..", targetAuth0);
+                return FALSE;
+            }
+            type2_plan_write(plan, &planned, cfg1, target + cfg1 * TYPE2_PAGE_SIZE);
+        }
+    }
+
+    // check every write of the plan against the tag as it is now
+    for (int i = 0; i < planned; i++) {
+        if (type2_page_locked(model, current, plan[i].page)) {
+            LOG_ERROR("Page 0x%02x of the %s is locked, but the image changes it. Aborting..", plan[i].page, model->name);
+            return FALSE;
+        }
+        if (type2_lock_bits_frozen(model, current, plan[i].data, plan[i].page)) {
+            LOG_ERROR("The image sets lock bits in page 0x%02x of the %s that its block-locking bits freeze. Aborting..", plan[i].page, model->name);
+            return FALSE;
+        }
+        if ((plan[i].page >= currentAuth0) && !acr_session_is_type2_authenticated(session, NULL)) {
+            LOG_ERROR("Page 0x%02x of the %s is protected by its password (AUTH0 0x%02x) and the tag is not authenticated (type2_authenticate), but the image changes it. Aborting..", plan[i].page, model->name, currentAuth0);
+            return FALSE;
+        }
+    }
+
+    LOG_DEBUG("Writing %d pages of the image to the %s.", planned, model->name);
+    for (int i = 0; i < planned; i++) {
+        if (!type2_write(plan[i].data, plan[i].page, session)) {
+            LOG_ERROR("Wrote %d of %d pages of the image, aborting..", i, planned);
+            return FALSE;
+        }
+        memcpy(current + plan[i].page * TYPE2_PAGE_SIZE, plan[i].data, TYPE2_PAGE_SIZE);
+    }
+    LOG_INFO("Wrote %d pages of the image to the %s, the others already had the wanted content.", planned, model->name);
+
+    return TRUE;
+}
+
+BOOL type2_write_image(const Type2TagModel *model, const BYTE *target, BYTE *current, acr_session *session) {
+    return ACR_SESSION_OPERATION(session, do_type2_write_image(model, target, current, session));
+}
+
+// -------------------------------- password ---------------------------------
+
+// type2_authenticate sends PWD_AUTH (1B) with the 4 byte password and compares the PACK the tag answers with to pack (2 bytes, NULL: do not check it,
+// a wrong PACK means the tag is not the one the password was set on). The tag stays authenticated until it leaves the field or answers with an error.
+// The session remembers it (see acr_session_is_type2_authenticated), so calling type2_authenticate before every operation of a batch costs no APDU
+static BOOL do_type2_authenticate(const Type2TagModel *model, const BYTE *password, const BYTE *pack, acr_session *session) {
+    BYTE *pbRecvBuffer = acr_session_recv_buffer(session);
+    if (model->configPage == 0x00) {
+        LOG_WARN("A %s can not be protected by a password.", model->name);
+        return FALSE;
+    }
+
+    if (acr_session_is_type2_authenticated(session, password)) {
+        LOG_DEBUG("The %s already is authenticated with this password.", model->name);
+        return TRUE;
+    }
+
+    // ff 00 00 00 07 (communicate with pn532 and 7 byte command will follow)
+    //      d4 (data exchange command)
+    //      42 (InCommunicateThru)
+    //      1b (PWD_AUTH) [page 46 of ntag21x document]
+    //      4 byte password
+    // Response:
+    //      d5 43 00
+    //      PACK (2 bytes)
+    //      90 00
+    BYTE APDU_Auth[8 + 4] = { 0xff, 0x00, 0x00, 0x00, 0x07, 0xd4, 0x42, 0x1b };
+    memcpy(APDU_Auth + 8, password, 4);
+    ApduResponse response = executeApdu(session, APDU_Auth, sizeof(APDU_Auth));
+    if (!isTagSuccessResponse(response, pbRecvBuffer, 3 + 2)) {
+        LOG_ERROR("The %s did not accept the password.", model->name);
+        return FALSE;
+    }
+    if ((pack != NULL) && (memcmp(pbRecvBuffer + 3, pack, 2) != 0)) {
+        LOG_ERROR("The %s accepted the password but answered with PACK %02x %02x instead of %02x %02x. Not trusting it..", model->name,
+            pbRecvBuffer[3], pbRecvBuffer[4], pack[0], pack[1]);
+        return FALSE;
+    }
+    acr_session_set_type2_authenticated(session, password);
+    LOG_INFO("Authenticated the %s with its password.", model->name);
+
+    return TRUE;
+}
+
+BOOL type2_authenticate(const Type2TagModel *model, const BYTE *password, const BYTE *pack, acr_session *session) {
+    return ACR_SESSION_OPERATION(session, do_type2_authenticate(model, password, pack, session));
+}
+
+// type2_set_protection sets up the password protection in one write sequence: PWD and PACK first (NULL: keep them), then CFG1 (PROT: readProtect),
+// then CFG0 (AUTH0: first protected page, 0xFF: none) last, so that the protection only starts once the password is in place. CFG0 / CFG1 are read
+// first, their other settings are kept and pages that would not change are not written. A tag that is protected already has to be authenticated first
+static BOOL do_type2_set_protection(const Type2TagModel *model, BYTE auth0, BOOL readProtect, const BYTE *password, const BYTE *pack, acr_session *session) {
+    if (model->configPage == 0x00) {
+        LOG_WARN("A %s can not be protected by a password.", model->name);
+        return FALSE;
+    }
+
+    BYTE config[2 * TYPE2_PAGE_SIZE];
+    Type2PageBuffer buffer = { config, model->configPage };
+    if (!type2_read_chunks(model, model->configPage, (BYTE)(model->configPage + 1), type2_copy_pages, &buffer, session)) {
+        LOG_ERROR("Could not read CFG0 / CFG1 of the %s (read protected? see type2_authenticate). Aborting..", model->name);
+        return FALSE;
+    }
+    if (config[TYPE2_PAGE_SIZE] & TYPE2_CFGLCK) {
+        LOG_ERROR("The configuration of the %s is locked (CFGLCK). Aborting..", model->name);
+        return FALSE;
+    }
+
+    Type2PlannedWrite plan[4];
+    int planned = 0;
+    BYTE data[TYPE2_PAGE_SIZE];
+    if (password != NULL) {
+        type2_plan_write(plan, &planned, model->configPage + 2, password);
+    }
+    if (pack != NULL) {
+        BYTE packPage[TYPE2_PAGE_SIZE] = { pack[0], pack[1], 0x00, 0x00 };
+        type2_plan_write(plan, &planned, model->configPage + 3, packPage);
+    }
+    memcpy(data, config + TYPE2_PAGE_SIZE, TYPE2_PAGE_SIZE);
+    data[0] = (BYTE)(readProtect ? (data[0] | TYPE2_PROT) : (data[0] & ~TYPE2_PROT));
+    if (data[0] != config[TYPE2_PAGE_SIZE]) {
+        type2_plan_write(plan, &planned, model->configPage + 1, data);
+    }
+    memcpy(data, config, TYPE2_PAGE_SIZE);
+    data[3] = auth0;
+    if (data[3] != config[3]) {
+        type2_plan_write(plan, &planned, model->configPage, data);
+    }
+
+    for (int i = 0; i < planned; i++) {
+        if ((plan[i].page >= config[3]) && !acr_session_is_type2_authenticated(session, NULL)) {
+            LOG_ERROR("The configuration of the %s is protected by its password (AUTH0 0x%02x), authenticate first (type2_authenticate). Aborting..", model->name, config[3]);
+            return FALSE;
+        }
+    }
+
+    for (int i = 0; i < planned; i++) {
+        if (!type2_write(plan[i].data, plan[i].page, session)) {
+            LOG_ERROR("Wrote %d of %d configuration pages, aborting..", i, planned);
+            return FALSE;
+        }
+    }
+    LOG_INFO("Protected the %s from page 0x%02x on (%s).", model->name, auth0, readProtect ? "read and write" : "write");
+
+    return TRUE;
+}
+
+BOOL type2_set_protection(const Type2TagModel *model, BYTE auth0, BOOL readProtect, const BYTE *password, const BYTE *pack, acr_session *session) {
+    return ACR_SESSION_OPERATION(session, do_type2_set_protection(model, auth0, readProtect, password, pack, session));
+}
+
+// type2_print_pages prints pages fromPage - toPage (pages[0] is fromPage)
+void type2_print_pages(BYTE fromPage, BYTE toPage, const BYTE *pages) {
+    for (int page = fromPage; page <= toPage; page++) {
+        const BYTE *data = pages + (page - fromPage) * TYPE2_PAGE_SIZE;
+        printf("[Page 0x%02X]\t0x%02X  0x%02X  0x%02X  0x%02X\n", page, data[0], data[1], data[2], data[3]);
+    }
+}
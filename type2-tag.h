@@ -0,0 +1,71 @@
+#ifndef TYPE2_TAG_H
+#define TYPE2_TAG_H
+
+#ifndef MAIN_H
+#include "main.h"
+#endif
+
+#ifndef COMMON_H
+#include "common.h"
+#endif
+
+#ifndef LOGGING_C
+#include "logging.c"
+#endif
+
+// One driver for the NFC Forum Type 2 tags (Mifare Ultralight, Ultralight EV1, NTAG 210 / 212 / 213 / 215 / 216). They all share the same
+// commands and the same memory layout (4 byte pages: UID + static lock bytes + capability container in pages 0x00 - 0x03, user memory from page 0x04 on,
+// then the dynamic lock bytes and the configuration pages), only the size differs. getStatus can not tell them apart, GET_VERSION (60) can:
+// type2_detect asks the tag once and returns its Type2TagModel, every other function takes the model.
+
+#define TYPE2_PAGE_SIZE 4
+#define TYPE2_MAX_PAGES 231                                             // NTAG 216
+#define TYPE2_TAG_NAME_UNDETERMINED "Mifare Ultralight or NTAG2xx"      // what getStatus calls all of them
+
+// Type2TagModel describes the memory of one tag type (see TYPE2_MODELS in type2-tag.c)
+typedef struct Type2TagModel {
+    const char *name;           // also the tag name of the session once detected (see acr_session_tag_name)
+    BYTE version[6];            // GET_VERSION bytes 1 - 6: vendor, product type, subtype, major / minor product version, storage size
+    BYTE amountPages;           // all pages, configuration pages included
+    BYTE lastUserPage;          // user memory is page 0x04 - lastUserPage
+    BYTE dynamicLockPage;       // 0x00: none (the static lock bytes are always in page 0x02)
+    BYTE dynamicLockPages;      // pages from page 0x10 on that one dynamic lock bit locks
+    BYTE configPage;            // CFG0, followed by CFG1, PWD and PACK. 0x00: none
+    BOOL fastRead;              // FAST_READ (3A), otherwise only READ (30) of 4 pages at once
+} Type2TagModel;
+
+// Type2PageCallback gets the pages of one exchange (firstPage - firstPage + amountPages - 1, 4 bytes each) straight out of the receive buffer:
+// data is only valid until the callback returns. Return FALSE to stop reading
+typedef BOOL (*Type2PageCallback)(BYTE firstPage, BYTE amountPages, const BYTE *data, void *arg);
+
+extern const Type2TagModel TYPE2_MODEL_ULTRALIGHT;
+extern const Type2TagModel TYPE2_MODEL_ULTRALIGHT_C;
+extern const Type2TagModel TYPE2_MODEL_ULTRALIGHT_EV1;     // MF0UL11
+extern const Type2TagModel TYPE2_MODEL_NTAG_213;
+extern const Type2TagModel TYPE2_MODEL_NTAG_215;
+extern const Type2TagModel TYPE2_MODEL_NTAG_216;
+
+// models
+const Type2TagModel *type2_model_of_tag(const char *tagName);
+const Type2TagModel *type2_model_of_version(const BYTE *version);
+BOOL type2_get_version(BYTE *version, acr_session *session);
+const Type2TagModel *type2_detect(acr_session *session);
+
+// functions
+BOOL type2_read_page(const Type2TagModel *model, BYTE page, acr_session *session);
+BOOL type2_fast_read(const Type2TagModel *model, BYTE fromPage, BYTE toPage, acr_session *session);
+BOOL type2_read_pages(const Type2TagModel *model, BYTE fromPage, BYTE toPage, BYTE *pages, size_t capacity, acr_session *session);
+BOOL type2_read_pages_with(const Type2TagModel *model, BYTE fromPage, BYTE toPage, Type2PageCallback onPages, void *arg, acr_session *session);
+BOOL type2_write_page(const Type2TagModel *model, const BYTE *data, BYTE page, acr_session *session);
+BOOL type2_reset_user_data(const Type2TagModel *model, acr_session *session);
+BOOL type2_write_changed_pages(const Type2TagModel *model, const BYTE *target, BYTE fromPage, BYTE toPage, acr_session *session);
+BOOL type2_reset_changed_user_data(const Type2TagModel *model, acr_session *session);
+BOOL type2_write_image(const Type2TagModel *model, const BYTE *target, BYTE *current, acr_session *session);
+
+// password protection (NTAG 21x, Ultralight EV1)
+BOOL type2_authenticate(const Type2TagModel *model, const BYTE *password, const BYTE *pack, acr_session *session);
+BOOL type2_set_protection(const Type2TagModel *model, BYTE auth0, BOOL readProtect, const BYTE *password, const BYTE *pack, acr_session *session);
+
+void type2_print_pages(BYTE fromPage, BYTE toPage, const BYTE *pages);
+
+#endif